@@ -28,6 +28,65 @@
 
 namespace libfreehand
 {
+
+enum FHColorConversion
+{
+  FH_COLOR_CONVERSION_EXACT, // every CMYK color through lcms2
+  FH_COLOR_CONVERSION_FAST   // a lookup table sampled from lcms2, max. CIE76 delta E of 3
+};
+
+// Kinds of records; groups, layers and the other structure are always parsed
+enum FHRecordCategory
+{
+  FH_RECORDS_GEOMETRY = 1 << 0,
+  FH_RECORDS_TEXT = 1 << 1,
+  FH_RECORDS_IMAGES = 1 << 2,
+  FH_RECORDS_STYLES = 1 << 3,
+  FH_RECORDS_COLORS = 1 << 4,
+  FH_RECORDS_ALL = FH_RECORDS_GEOMETRY | FH_RECORDS_TEXT | FH_RECORDS_IMAGES | FH_RECORDS_STYLES | FH_RECORDS_COLORS
+};
+
+struct FHParseOptions
+{
+  FHParseOptions()
+    : m_colorConversion(FH_COLOR_CONVERSION_EXACT), m_recordCategories(FH_RECORDS_ALL),
+      m_firstPage(0), m_lastPage(~0U),
+      m_clip(false), m_clipX(0.0), m_clipY(0.0), m_clipWidth(0.0), m_clipHeight(0.0) {}
+  FHColorConversion m_colorConversion;
+  // FHRecordCategory mask of the records to parse; the others are skipped
+  unsigned m_recordCategories;
+  // Range of the pages to output, 0-based and inclusive
+  unsigned m_firstPage;
+  unsigned m_lastPage;
+  // If set, objects lying wholly outside of the clip rectangle are not output.
+  // In inches, from the top left corner of each page
+  bool m_clip;
+  double m_clipX;
+  double m_clipY;
+  double m_clipWidth;
+  double m_clipHeight;
+};
+
+struct FHDocumentInfo
+{
+  FHDocumentInfo()
+    : m_version(0), m_pageWidth(0.0), m_pageHeight(0.0), m_layers(),
+      m_pageCount(0), m_recordCount(0), m_pathCount(0), m_textCount(0), m_imageCount(0) {}
+  int m_version; // FreeHand version
+  // of the first page, in inches
+  double m_pageWidth;
+  double m_pageHeight;
+  // in the order of the document, each with "librevenge:name" if the
+  // layer is named, and "librevenge:visible"
+  librevenge::RVNGPropertyListVector m_layers;
+  unsigned m_pageCount;
+  unsigned m_recordCount;
+  // paths and shapes; a composite path counts as the paths it is made of
+  unsigned m_pathCount;
+  unsigned m_textCount;
+  unsigned m_imageCount;
+};
+
 class FreeHandDocument
 {
 public:
@@ -35,6 +94,9 @@ public:
   static FHAPI bool isSupported(librevenge::RVNGInputStream *input);
 
   static FHAPI bool parse(librevenge::RVNGInputStream *input, librevenge::RVNGDrawingInterface *painter);
+  static FHAPI bool parse(librevenge::RVNGInputStream *input, librevenge::RVNGDrawingInterface *painter, const FHParseOptions &options);
+
+  static FHAPI bool getInfo(librevenge::RVNGInputStream *input, FHDocumentInfo &info);
 };
 
 } // namespace libfreehand
@@ -76,9 +76,12 @@ int main(int argc, char *argv[])
     return 1;
   }
 
+  libfreehand::FHParseOptions options;
+  options.m_recordCategories = libfreehand::FH_RECORDS_TEXT;
+
   librevenge::RVNGStringVector pages;
   librevenge::RVNGTextDrawingGenerator painter(pages);
-  if (!libfreehand::FreeHandDocument::parse(&input, &painter))
+  if (!libfreehand::FreeHandDocument::parse(&input, &painter, options))
   {
     fprintf(stderr, "ERROR: Parsing of document failed!\n");
     return 1;
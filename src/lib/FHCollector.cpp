@@ -9,8 +9,10 @@
 
 #include <algorithm>
 #include <cassert>
+#include <climits>
 #include <string.h>
 #include <librevenge/librevenge.h>
+#include <libfreehand/libfreehand.h>
 #include "FHCollector.h"
 #include "FHConstants.h"
 #include "libfreehand_utils.h"
@@ -40,6 +42,19 @@
 
 namespace
 {
+uint64_t hashData(const librevenge::RVNGBinaryData &data)
+{
+  // FNV-1a
+  uint64_t hash = 14695981039346656037ULL;
+  const unsigned char *buffer = data.getDataBuffer();
+  for (unsigned long i = 0; i < data.size(); ++i)
+  {
+    hash ^= buffer[i];
+    hash *= 1099511628211ULL;
+  }
+  return hash;
+}
+
 bool isTiff(const unsigned char *buffer, unsigned long size)
 {
   if (size < 4)
@@ -211,41 +226,61 @@ static void _composePath(librevenge::RVNGPropertyListVector &path, bool isClosed
   }
 }
 
+bool isSameTransform(const libfreehand::FHTransform &trafo1, const libfreehand::FHTransform &trafo2)
+{
+  return trafo1.m_m11 == trafo2.m_m11 && trafo1.m_m21 == trafo2.m_m21
+         && trafo1.m_m12 == trafo2.m_m12 && trafo1.m_m22 == trafo2.m_m22
+         && trafo1.m_m13 == trafo2.m_m13 && trafo1.m_m23 == trafo2.m_m23;
+}
+
+bool isVisited(const std::vector<bool> &visitedObjects, const unsigned id)
+{
+  return id < visitedObjects.size() && visitedObjects[id];
+}
+
 class ObjectRecursionGuard
 {
 public:
-  ObjectRecursionGuard(std::deque<unsigned> &objectStack, const unsigned id)
-    : m_objectStack(objectStack)
+  ObjectRecursionGuard(std::vector<bool> &visitedObjects, const unsigned id)
+    : m_visitedObjects(visitedObjects)
     , m_id(id)
   {
-    m_objectStack.push_front(m_id);
+    if (m_visitedObjects.size() <= m_id)
+      m_visitedObjects.resize(m_id + 1, false);
+    assert(!m_visitedObjects[m_id]);
+    m_visitedObjects[m_id] = true;
   }
 
   ~ObjectRecursionGuard()
   {
-    assert(!m_objectStack.empty());
-    assert(m_objectStack.front() == m_id);
-    m_objectStack.pop_front();
+    assert(m_visitedObjects[m_id]);
+    m_visitedObjects[m_id] = false;
   }
 
 private:
-  std::deque<unsigned> &m_objectStack;
+  std::vector<bool> &m_visitedObjects;
   const unsigned m_id;
 };
-
 }
 
 libfreehand::FHCollector::FHCollector() :
-  m_pageInfo(), m_fhTail(), m_block(), m_transforms(), m_paths(), m_strings(), m_names(), m_lists(),
-  m_layers(), m_groups(), m_clipGroups(), m_currentTransforms(), m_fakeTransforms(), m_compositePaths(),
-  m_pathTexts(), m_tStrings(), m_fonts(), m_tEffects(), m_paragraphs(), m_tabs(), m_textBloks(), m_textObjects(), m_charProperties(),
-  m_paragraphProperties(), m_rgbColors(), m_basicFills(), m_propertyLists(),
-  m_basicLines(), m_customProcs(), m_patternLines(), m_displayTexts(), m_graphicStyles(),
-  m_attributeHolders(), m_data(), m_dataLists(), m_images(), m_multiColorLists(), m_linearFills(),
-  m_tints(), m_lensFills(), m_radialFills(), m_newBlends(), m_filterAttributeHolders(), m_opacityFilters(),
-  m_shadowFilters(), m_glowFilters(), m_tileFills(), m_symbolClasses(), m_symbolInstances(), m_patternFills(),
-  m_linePatterns(), m_arrowPaths(),
-  m_strokeId(0), m_fillId(0), m_contentId(0), m_textBoxNumberId(0), m_visitedObjects()
+  m_pageInfo(), m_pages(), m_firstPage(0), m_lastPage(UINT_MAX),
+  m_clip(false), m_clipBox(), m_culling(false), m_cullingBox(),
+  m_layerElementBBoxes(), m_pageBox(), m_localPathBBoxes(), m_fhTail(), m_block(), m_recordIndex(), m_transforms(m_recordIndex), m_paths(m_recordIndex),
+  m_strings(m_recordIndex), m_names(), m_lists(m_recordIndex),
+  m_layers(m_recordIndex), m_groups(m_recordIndex), m_clipGroups(m_recordIndex), m_currentTransforms(), m_fakeTransforms(), m_compositePaths(m_recordIndex),
+  m_pathTexts(m_recordIndex), m_tStrings(m_recordIndex), m_fonts(m_recordIndex), m_tEffects(m_recordIndex), m_paragraphs(m_recordIndex), m_tabs(m_recordIndex), m_textBloks(m_recordIndex), m_textObjects(m_recordIndex), m_charProperties(m_recordIndex),
+  m_paragraphProperties(), m_rgbColors(m_recordIndex), m_basicFills(m_recordIndex), m_propertyLists(m_recordIndex),
+  m_basicLines(m_recordIndex), m_customProcs(m_recordIndex), m_patternLines(m_recordIndex), m_displayTexts(m_recordIndex), m_graphicStyles(m_recordIndex),
+  m_attributeHolders(m_recordIndex), m_data(m_recordIndex), m_dataLists(m_recordIndex), m_images(m_recordIndex), m_multiColorLists(m_recordIndex), m_linearFills(m_recordIndex),
+  m_tints(m_recordIndex), m_lensFills(m_recordIndex), m_radialFills(m_recordIndex), m_newBlends(m_recordIndex), m_filterAttributeHolders(m_recordIndex), m_opacityFilters(m_recordIndex),
+  m_shadowFilters(m_recordIndex), m_glowFilters(m_recordIndex), m_tileFills(m_recordIndex), m_symbolClasses(m_recordIndex), m_symbolInstances(m_recordIndex), m_patternFills(m_recordIndex),
+  m_linePatterns(m_recordIndex), m_arrowPaths(m_recordIndex),
+  m_strokeId(0), m_fillId(0), m_contentId(0), m_textBoxNumberId(0), m_visitedObjects(),
+  m_bBoxVisitedObjects(), m_bBoxCacheable(true),
+  m_bBoxCache(), m_bBoxCacheHits(0), m_bBoxCacheMisses(0), m_svgCache(), m_renderComplete(true),
+  m_imageData(), m_uniqueImageData(), m_dataChunkUses(), m_graphicStyleProperties(), m_graphicStyleCacheable(true),
+  m_colorTable()
 {
 }
 
@@ -258,6 +293,26 @@ void libfreehand::FHCollector::collectPageInfo(const FHPageInfo &pageInfo)
   m_pageInfo = pageInfo;
 }
 
+void libfreehand::FHCollector::collectPage(const FHPageInfo &page)
+{
+  m_pages.push_back(page);
+}
+
+void libfreehand::FHCollector::setPageRange(unsigned firstPage, unsigned lastPage)
+{
+  m_firstPage = firstPage;
+  m_lastPage = lastPage;
+}
+
+void libfreehand::FHCollector::setClipRect(double x, double y, double width, double height)
+{
+  m_clip = true;
+  m_clipBox.m_xmin = x;
+  m_clipBox.m_ymin = y;
+  m_clipBox.m_xmax = x + width;
+  m_clipBox.m_ymax = y + height;
+}
+
 void libfreehand::FHCollector::collectString(unsigned recordId, const librevenge::RVNGString &str)
 {
   m_strings[recordId] = str;
@@ -516,44 +571,52 @@ void libfreehand::FHCollector::collectSymbolInstance(unsigned recordId, const FH
   m_symbolInstances[recordId] = symbolInstance;
 }
 
-void libfreehand::FHCollector::_normalizePath(libfreehand::FHPath &path)
+const libfreehand::FHPath &libfreehand::FHCollector::_transformPath(const libfreehand::FHPath &path)
 {
-  FHTransform trafo(1.0, 0.0, 0.0, -1.0, - m_pageInfo.m_minX, m_pageInfo.m_maxY);
-  path.transform(trafo);
+
+  // The result is only valid until the next call
+  m_scratchPath = path;
+  m_scratchPath.transform(_getCurrentTransform(path.getXFormId()));
+  return m_scratchPath;
 }
 
-void libfreehand::FHCollector::_normalizePoint(double &x, double &y)
+void libfreehand::FHCollector::_pushTransform(const libfreehand::FHTransform &trafo)
 {
-  FHTransform trafo(1.0, 0.0, 0.0, -1.0, - m_pageInfo.m_minX, m_pageInfo.m_maxY);
-  trafo.applyToPoint(x, y);
+  FHTransform composed(trafo);
+  if (!m_currentTransforms.empty())
+    composed.multiply(m_currentTransforms.back());
+  m_currentTransforms.push_back(composed);
 }
 
-void libfreehand::FHCollector::_getBBofPath(const FHPath *path, libfreehand::FHBoundingBox &bBox)
+void libfreehand::FHCollector::_popTransform()
 {
-  if (!path || path->empty())
-    return;
-
-  FHPath fhPath(*path);
-  unsigned short xform = fhPath.getXFormId();
+  if (!m_currentTransforms.empty())
+    m_currentTransforms.pop_back();
+}
 
-  if (xform)
-  {
-    const FHTransform *trafo = _findTransform(xform);
-    if (trafo)
-      fhPath.transform(*trafo);
-  }
-  std::stack<FHTransform> groupTransforms(m_currentTransforms);
-  while (!groupTransforms.empty())
+libfreehand::FHTransform libfreehand::FHCollector::_getCurrentTransform(unsigned xFormId)
+{
+  FHTransform trafo;
+  if (xFormId)
   {
-    fhPath.transform(groupTransforms.top());
-    groupTransforms.pop();
+    const FHTransform *xform = _findTransform(xFormId);
+    if (xform)
+      trafo = *xform;
   }
-  _normalizePath(fhPath);
+  if (!m_currentTransforms.empty())
+    trafo.multiply(m_currentTransforms.back());
+  trafo.multiply(FHTransform(1.0, 0.0, 0.0, -1.0, - m_pageInfo.m_minX, m_pageInfo.m_maxY));
   for (std::vector<FHTransform>::const_iterator iter = m_fakeTransforms.begin(); iter != m_fakeTransforms.end(); ++iter)
-  {
-    fhPath.transform(*iter);
-  }
+    trafo.multiply(*iter);
+  return trafo;
+}
 
+void libfreehand::FHCollector::_getBBofPath(const FHPath *path, libfreehand::FHBoundingBox &bBox)
+{
+  if (!path || path->empty())
+    return;
+
+  const FHPath &fhPath = _transformPath(*path);
   FHBoundingBox tmpBBox;
   fhPath.getBoundingBox(tmpBBox.m_xmin, tmpBBox.m_ymin, tmpBBox.m_xmax, tmpBBox.m_ymax);
   bBox.merge(tmpBBox);
@@ -568,12 +631,12 @@ void libfreehand::FHCollector::_getBBofGroup(const FHGroup *group, libfreehand::
   {
     const FHTransform *trafo = _findTransform(group->m_xFormId);
     if (trafo)
-      m_currentTransforms.push(*trafo);
+      _pushTransform(*trafo);
     else
-      m_currentTransforms.push(libfreehand::FHTransform());
+      _pushTransform(libfreehand::FHTransform());
   }
   else
-    m_currentTransforms.push(libfreehand::FHTransform());
+    _pushTransform(libfreehand::FHTransform());
 
   const std::vector<unsigned> *elements = _findListElements(group->m_elementsId);
   if (!elements)
@@ -589,8 +652,7 @@ void libfreehand::FHCollector::_getBBofGroup(const FHGroup *group, libfreehand::
     bBox.merge(tmpBBox);
   }
 
-  if (!m_currentTransforms.empty())
-    m_currentTransforms.pop();
+  _popTransform();
 }
 
 void libfreehand::FHCollector::_getBBofClipGroup(const FHGroup *group, libfreehand::FHBoundingBox &bBox)
@@ -602,12 +664,12 @@ void libfreehand::FHCollector::_getBBofClipGroup(const FHGroup *group, libfreeha
   {
     const FHTransform *trafo = _findTransform(group->m_xFormId);
     if (trafo)
-      m_currentTransforms.push(*trafo);
+      _pushTransform(*trafo);
     else
-      m_currentTransforms.push(libfreehand::FHTransform());
+      _pushTransform(libfreehand::FHTransform());
   }
   else
-    m_currentTransforms.push(libfreehand::FHTransform());
+    _pushTransform(libfreehand::FHTransform());
 
   const std::vector<unsigned> *elements = _findListElements(group->m_elementsId);
   if (!elements)
@@ -621,8 +683,7 @@ void libfreehand::FHCollector::_getBBofClipGroup(const FHGroup *group, libfreeha
   _getBBofSomething(*iterVec, tmpBBox);
   bBox.merge(tmpBBox);
 
-  if (!m_currentTransforms.empty())
-    m_currentTransforms.pop();
+  _popTransform();
 }
 
 void libfreehand::FHCollector::_getBBofCompositePath(const FHCompositePath *compositePath, libfreehand::FHBoundingBox &bBox)
@@ -680,39 +741,11 @@ void libfreehand::FHCollector::_getBBofTextObject(const FHTextObject *textObject
   double yc = yb;
   double xd = xb;
   double yd = ya;
-  unsigned xFormId = textObject->m_xFormId;
-  if (xFormId)
-  {
-    const FHTransform *trafo = _findTransform(xFormId);
-    if (trafo)
-    {
-      trafo->applyToPoint(xa, ya);
-      trafo->applyToPoint(xb, yb);
-      trafo->applyToPoint(xc, yc);
-      trafo->applyToPoint(xd, yd);
-    }
-  }
-  std::stack<FHTransform> groupTransforms(m_currentTransforms);
-  while (!groupTransforms.empty())
-  {
-    groupTransforms.top().applyToPoint(xa, ya);
-    groupTransforms.top().applyToPoint(xb, yb);
-    groupTransforms.top().applyToPoint(xc, yc);
-    groupTransforms.top().applyToPoint(xd, yd);
-    groupTransforms.pop();
-  }
-  _normalizePoint(xa, ya);
-  _normalizePoint(xb, yb);
-  _normalizePoint(xc, yc);
-  _normalizePoint(xd, yd);
-
-  for (std::vector<FHTransform>::const_iterator iter = m_fakeTransforms.begin(); iter != m_fakeTransforms.end(); ++iter)
-  {
-    iter->applyToPoint(xa, ya);
-    iter->applyToPoint(xb, yb);
-    iter->applyToPoint(xc, yc);
-    iter->applyToPoint(xd, yd);
-  }
+  const FHTransform trafo = _getCurrentTransform(textObject->m_xFormId);
+  trafo.applyToPoint(xa, ya);
+  trafo.applyToPoint(xb, yb);
+  trafo.applyToPoint(xc, yc);
+  trafo.applyToPoint(xd, yd);
 
   FHBoundingBox tmpBBox;
   if (xa < tmpBBox.m_xmin) tmpBBox.m_xmin = xa;
@@ -750,39 +783,11 @@ void libfreehand::FHCollector::_getBBofDisplayText(const FHDisplayText *displayT
   double yc = yb;
   double xd = xb;
   double yd = ya;
-  unsigned xFormId = displayText->m_xFormId;
-  if (xFormId)
-  {
-    const FHTransform *trafo = _findTransform(xFormId);
-    if (trafo)
-    {
-      trafo->applyToPoint(xa, ya);
-      trafo->applyToPoint(xb, yb);
-      trafo->applyToPoint(xc, yc);
-      trafo->applyToPoint(xd, yd);
-    }
-  }
-  std::stack<FHTransform> groupTransforms(m_currentTransforms);
-  while (!groupTransforms.empty())
-  {
-    groupTransforms.top().applyToPoint(xa, ya);
-    groupTransforms.top().applyToPoint(xb, yb);
-    groupTransforms.top().applyToPoint(xc, yc);
-    groupTransforms.top().applyToPoint(xd, yd);
-    groupTransforms.pop();
-  }
-  _normalizePoint(xa, ya);
-  _normalizePoint(xb, yb);
-  _normalizePoint(xc, yc);
-  _normalizePoint(xd, yd);
-
-  for (std::vector<FHTransform>::const_iterator iter = m_fakeTransforms.begin(); iter != m_fakeTransforms.end(); ++iter)
-  {
-    iter->applyToPoint(xa, ya);
-    iter->applyToPoint(xb, yb);
-    iter->applyToPoint(xc, yc);
-    iter->applyToPoint(xd, yd);
-  }
+  const FHTransform trafo = _getCurrentTransform(displayText->m_xFormId);
+  trafo.applyToPoint(xa, ya);
+  trafo.applyToPoint(xb, yb);
+  trafo.applyToPoint(xc, yc);
+  trafo.applyToPoint(xd, yd);
 
   FHBoundingBox tmpBBox;
   if (xa < tmpBBox.m_xmin) tmpBBox.m_xmin = xa;
@@ -820,39 +825,11 @@ void libfreehand::FHCollector::_getBBofImageImport(const FHImageImport *image, l
   double yc = yb;
   double xd = xb;
   double yd = ya;
-  unsigned xFormId = image->m_xFormId;
-  if (xFormId)
-  {
-    const FHTransform *trafo = _findTransform(xFormId);
-    if (trafo)
-    {
-      trafo->applyToPoint(xa, ya);
-      trafo->applyToPoint(xb, yb);
-      trafo->applyToPoint(xc, yc);
-      trafo->applyToPoint(xd, yd);
-    }
-  }
-  std::stack<FHTransform> groupTransforms(m_currentTransforms);
-  while (!groupTransforms.empty())
-  {
-    groupTransforms.top().applyToPoint(xa, ya);
-    groupTransforms.top().applyToPoint(xb, yb);
-    groupTransforms.top().applyToPoint(xc, yc);
-    groupTransforms.top().applyToPoint(xd, yd);
-    groupTransforms.pop();
-  }
-  _normalizePoint(xa, ya);
-  _normalizePoint(xb, yb);
-  _normalizePoint(xc, yc);
-  _normalizePoint(xd, yd);
-
-  for (std::vector<FHTransform>::const_iterator iter = m_fakeTransforms.begin(); iter != m_fakeTransforms.end(); ++iter)
-  {
-    iter->applyToPoint(xa, ya);
-    iter->applyToPoint(xb, yb);
-    iter->applyToPoint(xc, yc);
-    iter->applyToPoint(xd, yd);
-  }
+  const FHTransform trafo = _getCurrentTransform(image->m_xFormId);
+  trafo.applyToPoint(xa, ya);
+  trafo.applyToPoint(xb, yb);
+  trafo.applyToPoint(xc, yc);
+  trafo.applyToPoint(xd, yd);
 
   FHBoundingBox tmpBBox;
   if (xa < tmpBBox.m_xmin) tmpBBox.m_xmin = xa;
@@ -886,7 +863,7 @@ void libfreehand::FHCollector::_getBBofSymbolInstance(const FHSymbolInstance *sy
   if (!symbolInstance)
     return;
 
-  m_currentTransforms.push(symbolInstance->m_xForm);
+  _pushTransform(symbolInstance->m_xForm);
 
   const FHSymbolClass *symbolClass = _findSymbolClass(symbolInstance->m_symbolClassId);
   if (symbolClass)
@@ -896,64 +873,143 @@ void libfreehand::FHCollector::_getBBofSymbolInstance(const FHSymbolInstance *sy
     bBox.merge(tmpBBox);
   }
 
-  if (!m_currentTransforms.empty())
-    m_currentTransforms.pop();
+  _popTransform();
 }
 
 void libfreehand::FHCollector::_getBBofSomething(unsigned somethingId, libfreehand::FHBoundingBox &bBox)
 {
   if (!somethingId)
     return;
+  if (isVisited(m_bBoxVisitedObjects, somethingId))
+  {
+    // A subtree that contains itself; the part found so far must not be remembered
+    m_bBoxCacheable = false;
+    return;
+  }
+
+  // Only the records that own a subtree are worth remembering
+  const FHRecordType type = _getRecordType(somethingId);
+  const bool memoize = type == FH_RECORD_GROUP || type == FH_RECORD_CLIP_GROUP
+                       || type == FH_RECORD_COMPOSITE_PATH || type == FH_RECORD_SYMBOL_INSTANCE;
+  FHTransform context;
+  if (memoize)
+  {
+    context = _getCurrentTransform(0);
+    auto iter = m_bBoxCache.find(somethingId);
+    if (iter != m_bBoxCache.end() && isSameTransform(iter->second.first, context))
+    {
+      ++m_bBoxCacheHits;
+      bBox.merge(iter->second.second);
+      return;
+    }
+    ++m_bBoxCacheMisses;
+  }
 
+  const ObjectRecursionGuard guard(m_bBoxVisitedObjects, somethingId);
+  const bool outerCacheable = m_bBoxCacheable;
+  m_bBoxCacheable = true;
   FHBoundingBox tmpBBox;
-  _getBBofGroup(_findGroup(somethingId), tmpBBox);
-  _getBBofClipGroup(_findClipGroup(somethingId), tmpBBox);
-  _getBBofPathText(_findPathText(somethingId), tmpBBox);
-  _getBBofPath(_findPath(somethingId), tmpBBox);
-  _getBBofCompositePath(_findCompositePath(somethingId), tmpBBox);
-  _getBBofTextObject(_findTextObject(somethingId), tmpBBox);
-  _getBBofDisplayText(_findDisplayText(somethingId), tmpBBox);
-  _getBBofImageImport(_findImageImport(somethingId), tmpBBox);
-  _getBBofNewBlend(_findNewBlend(somethingId), tmpBBox);
-  _getBBofSymbolInstance(_findSymbolInstance(somethingId), tmpBBox);
+  switch (type)
+  {
+  case FH_RECORD_GROUP:
+    _getBBofGroup(_findGroup(somethingId), tmpBBox);
+    break;
+  case FH_RECORD_CLIP_GROUP:
+    _getBBofClipGroup(_findClipGroup(somethingId), tmpBBox);
+    break;
+  case FH_RECORD_PATH_TEXT:
+    _getBBofPathText(_findPathText(somethingId), tmpBBox);
+    break;
+  case FH_RECORD_PATH:
+    _getBBofPath(_findPath(somethingId), tmpBBox);
+    break;
+  case FH_RECORD_COMPOSITE_PATH:
+    _getBBofCompositePath(_findCompositePath(somethingId), tmpBBox);
+    break;
+  case FH_RECORD_TEXT_OBJECT:
+    _getBBofTextObject(_findTextObject(somethingId), tmpBBox);
+    break;
+  case FH_RECORD_DISPLAY_TEXT:
+    _getBBofDisplayText(_findDisplayText(somethingId), tmpBBox);
+    break;
+  case FH_RECORD_IMAGE:
+    _getBBofImageImport(_findImageImport(somethingId), tmpBBox);
+    break;
+  case FH_RECORD_NEW_BLEND:
+    _getBBofNewBlend(_findNewBlend(somethingId), tmpBBox);
+    break;
+  case FH_RECORD_SYMBOL_INSTANCE:
+    _getBBofSymbolInstance(_findSymbolInstance(somethingId), tmpBBox);
+    break;
+  default:
+    break;
+  }
+  if (memoize && m_bBoxCacheable)
+    m_bBoxCache[somethingId] = std::make_pair(context, tmpBBox);
+  m_bBoxCacheable = outerCacheable && m_bBoxCacheable;
   bBox.merge(tmpBBox);
 }
 
 
+librevenge::RVNGBinaryData libfreehand::FHCollector::_renderToSVG(unsigned somethingId, double width, double height, bool cache)
+{
+  const FHTransform context = cache ? _getCurrentTransform(0) : FHTransform();
+  if (cache)
+  {
+    auto iter = m_svgCache.find(somethingId);
+    if (iter != m_svgCache.end())
+    {
+      for (const auto &svg : iter->second)
+      {
+        if (svg.m_width == width && svg.m_height == height && isSameTransform(svg.m_context, context))
+          return svg.m_data;
+      }
+    }
+  }
+
+  const bool outerComplete = m_renderComplete;
+  m_renderComplete = true;
+
+  librevenge::RVNGStringVector svgOutput;
+  librevenge::RVNGSVGDrawingGenerator generator(svgOutput, "");
+  librevenge::RVNGPropertyList propList;
+  propList.insert("svg:width", width);
+  propList.insert("svg:height", height);
+  generator.startPage(propList);
+  _outputSomething(somethingId, &generator);
+  generator.endPage();
+
+  RenderedSVG svg;
+  svg.m_context = context;
+  svg.m_width = width;
+  svg.m_height = height;
+  if (!svgOutput.empty() && svgOutput[0].size() > 140) // basically empty svg if it is not fullfilled
+  {
+    const char *header =
+      "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"no\"?>\n<!DOCTYPE svg PUBLIC \"-//W3C//DTD SVG 1.1//EN\" \"http://www.w3.org/Graphics/SVG/1.1/DTD/svg11.dtd\">\n";
+    svg.m_data.append((const unsigned char *)header, strlen(header));
+    svg.m_data.append((const unsigned char *)svgOutput[0].cstr(), strlen(svgOutput[0].cstr()));
+  }
+  // A rendering that left out a reference back into the objects being
+  // drawn must not stick for the uses outside of the cycle
+  if (cache && m_renderComplete)
+    m_svgCache[somethingId].push_back(svg);
+  m_renderComplete = outerComplete && m_renderComplete;
+  // RVNGBinaryData copies share the buffer
+  return svg.m_data;
+}
+
 void libfreehand::FHCollector::_outputPath(const libfreehand::FHPath *path, librevenge::RVNGDrawingInterface *painter)
 {
   if (!painter || !path || path->empty())
     return;
 
-  FHPath fhPath(*path);
-  librevenge::RVNGPropertyList propList;
-  _appendStrokeProperties(propList, fhPath.getGraphicStyleId());
-  _appendFillProperties(propList, fhPath.getGraphicStyleId());
-  unsigned contentId = _findContentId(fhPath.getGraphicStyleId());
-  if (fhPath.getEvenOdd())
+  librevenge::RVNGPropertyList propList = _getGraphicStyleProperties(path->getGraphicStyleId());
+  unsigned contentId = _findContentId(path->getGraphicStyleId());
+  if (path->getEvenOdd())
     propList.insert("svg:fill-rule", "evenodd");
 
-  unsigned short xform = fhPath.getXFormId();
-
-  if (xform)
-  {
-    const FHTransform *trafo = _findTransform(xform);
-    if (trafo)
-      fhPath.transform(*trafo);
-  }
-  std::stack<FHTransform> groupTransforms(m_currentTransforms);
-  while (!groupTransforms.empty())
-  {
-    fhPath.transform(groupTransforms.top());
-    groupTransforms.pop();
-  }
-  _normalizePath(fhPath);
-
-  for (std::vector<FHTransform>::const_iterator iter = m_fakeTransforms.begin(); iter != m_fakeTransforms.end(); ++iter)
-  {
-    fhPath.transform(*iter);
-  }
-
+  const FHPath &fhPath = _transformPath(*path);
   librevenge::RVNGPropertyListVector propVec;
   fhPath.writeOut(propVec);
   if (propList["draw:fill"] && propList["draw:fill"]->getStr() != "none")
@@ -972,20 +1028,10 @@ void libfreehand::FHCollector::_outputPath(const libfreehand::FHPath *path, libr
     fhPath.getBoundingBox(bBox.m_xmin, bBox.m_ymin, bBox.m_xmax, bBox.m_ymax);
     FHTransform trafo(1.0, 0.0, 0.0, 1.0, - bBox.m_xmin, - bBox.m_ymin);
     m_fakeTransforms.push_back(trafo);
-    librevenge::RVNGStringVector svgOutput;
-    librevenge::RVNGSVGDrawingGenerator generator(svgOutput, "");
-    propList.clear();
-    propList.insert("svg:width", bBox.m_xmax - bBox.m_xmin);
-    propList.insert("svg:height", bBox.m_ymax - bBox.m_ymin);
-    generator.startPage(propList);
-    _outputSomething(contentId, &generator);
-    generator.endPage();
-    if (!svgOutput.empty() && svgOutput[0].size() > 140) // basically empty svg if it is not fullfilled
+    // the context holds the position of the path, so it would hardly ever be reused
+    const librevenge::RVNGBinaryData output = _renderToSVG(contentId, bBox.m_xmax - bBox.m_xmin, bBox.m_ymax - bBox.m_ymin, false);
+    if (!output.empty())
     {
-      const char *header =
-        "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"no\"?>\n<!DOCTYPE svg PUBLIC \"-//W3C//DTD SVG 1.1//EN\" \"http://www.w3.org/Graphics/SVG/1.1/DTD/svg11.dtd\">\n";
-      librevenge::RVNGBinaryData output((const unsigned char *)header, strlen(header));
-      output.append((unsigned char *)svgOutput[0].cstr(), strlen(svgOutput[0].cstr()));
 #if DUMP_CONTENTS
       {
         librevenge::RVNGString filename;
@@ -1019,13 +1065,13 @@ void libfreehand::FHCollector::_outputPath(const libfreehand::FHPath *path, libr
     rectangleProps.insert("draw:fill", "none");
     rectangleProps.insert("draw:stroke", "solid");
     painter->setStyle(rectangleProps);
-    double xmin, ymin, xmax, ymax;
-    fhPath.getBoundingBox(xmin, ymin, xmax, ymax);
+    FHBoundingBox bBox;
+    _getBBofPath(path, bBox);
     librevenge::RVNGPropertyList rectangleList;
-    rectangleList.insert("svg:x", xmin);
-    rectangleList.insert("svg:y", ymin);
-    rectangleList.insert("svg:width", xmax - xmin);
-    rectangleList.insert("svg:height", ymax - ymin);
+    rectangleList.insert("svg:x", bBox.m_xmin);
+    rectangleList.insert("svg:y", bBox.m_ymin);
+    rectangleList.insert("svg:width", bBox.m_xmax - bBox.m_xmin);
+    rectangleList.insert("svg:height", bBox.m_ymax - bBox.m_ymin);
     painter->drawRectangle(rectangleList);
   }
 #endif
@@ -1035,21 +1081,51 @@ void libfreehand::FHCollector::_outputSomething(unsigned somethingId, librevenge
 {
   if (!painter || !somethingId)
     return;
-  if (find(m_visitedObjects.begin(), m_visitedObjects.end(), somethingId) != m_visitedObjects.end())
+  if (isVisited(m_visitedObjects, somethingId))
+  {
+    m_renderComplete = false;
+    return;
+  }
+  if (_isCulled(somethingId))
     return;
 
   const ObjectRecursionGuard guard(m_visitedObjects, somethingId);
 
-  _outputGroup(_findGroup(somethingId), painter);
-  _outputClipGroup(_findClipGroup(somethingId), painter);
-  _outputPathText(_findPathText(somethingId), painter);
-  _outputPath(_findPath(somethingId), painter);
-  _outputCompositePath(_findCompositePath(somethingId), painter);
-  _outputTextObject(_findTextObject(somethingId), painter);
-  _outputDisplayText(_findDisplayText(somethingId), painter);
-  _outputImageImport(_findImageImport(somethingId), painter);
-  _outputNewBlend(_findNewBlend(somethingId), painter);
-  _outputSymbolInstance(_findSymbolInstance(somethingId), painter);
+  switch (_getRecordType(somethingId))
+  {
+  case FH_RECORD_GROUP:
+    _outputGroup(_findGroup(somethingId), painter);
+    break;
+  case FH_RECORD_CLIP_GROUP:
+    _outputClipGroup(_findClipGroup(somethingId), painter);
+    break;
+  case FH_RECORD_PATH_TEXT:
+    _outputPathText(_findPathText(somethingId), painter);
+    break;
+  case FH_RECORD_PATH:
+    _outputPath(_findPath(somethingId), painter);
+    break;
+  case FH_RECORD_COMPOSITE_PATH:
+    _outputCompositePath(_findCompositePath(somethingId), painter);
+    break;
+  case FH_RECORD_TEXT_OBJECT:
+    _outputTextObject(_findTextObject(somethingId), painter);
+    break;
+  case FH_RECORD_DISPLAY_TEXT:
+    _outputDisplayText(_findDisplayText(somethingId), painter);
+    break;
+  case FH_RECORD_IMAGE:
+    _outputImageImport(_findImageImport(somethingId), painter);
+    break;
+  case FH_RECORD_NEW_BLEND:
+    _outputNewBlend(_findNewBlend(somethingId), painter);
+    break;
+  case FH_RECORD_SYMBOL_INSTANCE:
+    _outputSymbolInstance(_findSymbolInstance(somethingId), painter);
+    break;
+  default:
+    break;
+  }
 }
 
 void libfreehand::FHCollector::_outputGroup(const libfreehand::FHGroup *group, librevenge::RVNGDrawingInterface *painter)
@@ -1061,12 +1137,12 @@ void libfreehand::FHCollector::_outputGroup(const libfreehand::FHGroup *group, l
   {
     const FHTransform *trafo = _findTransform(group->m_xFormId);
     if (trafo)
-      m_currentTransforms.push(*trafo);
+      _pushTransform(*trafo);
     else
-      m_currentTransforms.push(libfreehand::FHTransform());
+      _pushTransform(libfreehand::FHTransform());
   }
   else
-    m_currentTransforms.push(libfreehand::FHTransform());
+    _pushTransform(libfreehand::FHTransform());
 
   const std::vector<unsigned> *elements = _findListElements(group->m_elementsId);
   if (!elements)
@@ -1083,8 +1159,7 @@ void libfreehand::FHCollector::_outputGroup(const libfreehand::FHGroup *group, l
     painter->closeGroup();
   }
 
-  if (!m_currentTransforms.empty())
-    m_currentTransforms.pop();
+  _popTransform();
 }
 
 void libfreehand::FHCollector::_outputClipGroup(const libfreehand::FHGroup *group, librevenge::RVNGDrawingInterface *painter)
@@ -1111,42 +1186,19 @@ void libfreehand::FHCollector::_outputClipGroup(const libfreehand::FHGroup *grou
       {
         const FHTransform *trafo = _findTransform(group->m_xFormId);
         if (trafo)
-          m_currentTransforms.push(*trafo);
+          _pushTransform(*trafo);
         else
-          m_currentTransforms.push(libfreehand::FHTransform());
+          _pushTransform(libfreehand::FHTransform());
       }
       else
-        m_currentTransforms.push(libfreehand::FHTransform());
+        _pushTransform(libfreehand::FHTransform());
 
-      librevenge::RVNGPropertyList propList;
-      FHPath fhPath(*path);
-      _appendStrokeProperties(propList, fhPath.getGraphicStyleId());
-      _appendFillProperties(propList, fhPath.getGraphicStyleId());
-      if (fhPath.getEvenOdd())
+      librevenge::RVNGPropertyList propList = _getGraphicStyleProperties(path->getGraphicStyleId());
+      if (path->getEvenOdd())
         propList.insert("svg:fill-rule", "evenodd");
-      unsigned short xform = fhPath.getXFormId();
+      const FHPath &fhPath = _transformPath(*path);
 
-      if (xform)
-      {
-        const FHTransform *trafo = _findTransform(xform);
-        if (trafo)
-          fhPath.transform(*trafo);
-      }
-      std::stack<FHTransform> groupTransforms(m_currentTransforms);
-      while (!groupTransforms.empty())
-      {
-        fhPath.transform(groupTransforms.top());
-        groupTransforms.pop();
-      }
-      _normalizePath(fhPath);
-
-      for (std::vector<FHTransform>::const_iterator iterVec = m_fakeTransforms.begin(); iterVec != m_fakeTransforms.end(); ++iterVec)
-      {
-        fhPath.transform(*iterVec);
-      }
-
-      if (!m_currentTransforms.empty())
-        m_currentTransforms.pop();
+      _popTransform();
 
       librevenge::RVNGPropertyListVector propVec;
       fhPath.writeOut(propVec);
@@ -1214,7 +1266,7 @@ void libfreehand::FHCollector::_outputNewBlend(const libfreehand::FHNewBlend *ne
   if (!painter || !newBlend)
     return;
 
-  m_currentTransforms.push(libfreehand::FHTransform());
+  _pushTransform(libfreehand::FHTransform());
 
   painter->openGroup(librevenge::RVNGPropertyList());
   const std::vector<unsigned> *elements1 = _findListElements(newBlend->m_list1Id);
@@ -1237,8 +1289,7 @@ void libfreehand::FHCollector::_outputNewBlend(const libfreehand::FHNewBlend *ne
   }
   painter->closeGroup();
 
-  if (!m_currentTransforms.empty())
-    m_currentTransforms.pop();
+  _popTransform();
 }
 
 void libfreehand::FHCollector::_outputSymbolInstance(const libfreehand::FHSymbolInstance *symbolInstance, librevenge::RVNGDrawingInterface *painter)
@@ -1246,7 +1297,7 @@ void libfreehand::FHCollector::_outputSymbolInstance(const libfreehand::FHSymbol
   if (!painter || !symbolInstance)
     return;
 
-  m_currentTransforms.push(symbolInstance->m_xForm);
+  _pushTransform(symbolInstance->m_xForm);
 
   const FHSymbolClass *symbolClass = _findSymbolClass(symbolInstance->m_symbolClassId);
   if (symbolClass)
@@ -1254,15 +1305,14 @@ void libfreehand::FHCollector::_outputSymbolInstance(const libfreehand::FHSymbol
     _outputSomething(symbolClass->m_groupId, painter);
   }
 
-  if (!m_currentTransforms.empty())
-    m_currentTransforms.pop();
+  _popTransform();
 }
 
 void libfreehand::FHCollector::outputDrawing(librevenge::RVNGDrawingInterface *painter)
 {
 
 #if DUMP_BINARY_OBJECTS
-  for (std::map<unsigned, FHImageImport>::const_iterator iterImage = m_images.begin(); iterImage != m_images.end(); ++iterImage)
+  for (auto iterImage = m_images.begin(); iterImage != m_images.end(); ++iterImage)
   {
     librevenge::RVNGBinaryData data = getImageData(iterImage->second.m_dataListId);
     librevenge::RVNGString filename;
@@ -1295,24 +1345,96 @@ void libfreehand::FHCollector::outputDrawing(librevenge::RVNGDrawingInterface *p
   if (FH_UNINITIALIZED(m_pageInfo))
     m_pageInfo = m_fhTail.m_pageInfo;
 
+  // A document with a single page is output whole, with its pasteboard
+  const bool multiPage = m_pages.size() > 1;
+  const std::vector<FHPageInfo> pages = multiPage ? m_pages : std::vector<FHPageInfo>(1, m_pageInfo);
+  const FHPageInfo pageInfo = m_pageInfo;
+  if (multiPage)
+    _buildLayerElementBBoxes();
+
   painter->startDocument(librevenge::RVNGPropertyList());
-  librevenge::RVNGPropertyList propList;
-  propList.insert("svg:height", m_pageInfo.m_maxY - m_pageInfo.m_minY);
-  propList.insert("svg:width", m_pageInfo.m_maxX - m_pageInfo.m_minX);
-  painter->startPage(propList);
+  for (unsigned i = m_firstPage; i < pages.size() && i <= m_lastPage; ++i)
+  {
+    m_pageInfo = pages[i];
+    librevenge::RVNGPropertyList propList;
+    propList.insert("svg:height", m_pageInfo.m_maxY - m_pageInfo.m_minY);
+    propList.insert("svg:width", m_pageInfo.m_maxX - m_pageInfo.m_minX);
+    painter->startPage(propList);
+
+    // The page, in the coordinates of the layer element bounding boxes;
+    // the normalizations of the pages only differ by a translation
+    m_pageBox.m_xmin = m_pageInfo.m_minX - pageInfo.m_minX;
+    m_pageBox.m_ymin = pageInfo.m_maxY - m_pageInfo.m_maxY;
+    m_pageBox.m_xmax = m_pageBox.m_xmin + m_pageInfo.m_maxX - m_pageInfo.m_minX;
+    m_pageBox.m_ymax = m_pageBox.m_ymin + m_pageInfo.m_maxY - m_pageInfo.m_minY;
+
+    m_culling = m_clip;
+    m_cullingBox.m_xmin = m_clipBox.m_xmin;
+    m_cullingBox.m_ymin = m_clipBox.m_ymin;
+    m_cullingBox.m_xmax = m_clipBox.m_xmax;
+    m_cullingBox.m_ymax = m_clipBox.m_ymax;
+    if (multiPage)
+    {
+      m_cullingBox.m_xmin = std::max(m_cullingBox.m_xmin, 0.0);
+      m_cullingBox.m_ymin = std::max(m_cullingBox.m_ymin, 0.0);
+      m_cullingBox.m_xmax = std::min(m_cullingBox.m_xmax, m_pageInfo.m_maxX - m_pageInfo.m_minX);
+      m_cullingBox.m_ymax = std::min(m_cullingBox.m_ymax, m_pageInfo.m_maxY - m_pageInfo.m_minY);
+    }
 
-  unsigned layerListId = m_block.second.m_layerListId;
+    unsigned layerListId = m_block.second.m_layerListId;
 
-  const std::vector<unsigned> *elements = _findListElements(layerListId);
-  if (elements)
-  {
-    for (unsigned int element : *elements)
+    const std::vector<unsigned> *elements = _findListElements(layerListId);
+    if (elements)
     {
-      _outputLayer(element, painter);
+      for (unsigned int element : *elements)
+      {
+        _outputLayer(element, painter);
+      }
     }
+    painter->endPage();
   }
-  painter->endPage();
   painter->endDocument();
+  m_pageInfo = pageInfo;
+  m_culling = false;
+  m_layerElementBBoxes.clear();
+
+  FH_DEBUG_MSG(("Bounding box cache: %lu hits, %lu misses\n", m_bBoxCacheHits, m_bBoxCacheMisses));
+}
+
+void libfreehand::FHCollector::getBoundingBoxCacheStats(unsigned long &hits, unsigned long &misses) const
+{
+  hits = m_bBoxCacheHits;
+  misses = m_bBoxCacheMisses;
+}
+
+void libfreehand::FHCollector::getDocumentInfo(FHDocumentInfo &info)
+{
+  FHPageInfo pageInfo = m_pageInfo;
+  if (FH_UNINITIALIZED(pageInfo))
+    pageInfo = m_fhTail.m_pageInfo;
+  // m_pageInfo spans all the pages of a multi-page document
+  if (m_pages.size() > 1)
+    pageInfo = m_pages.front();
+  info.m_pageWidth = pageInfo.m_maxX - pageInfo.m_minX;
+  info.m_pageHeight = pageInfo.m_maxY - pageInfo.m_minY;
+  info.m_pageCount = m_pages.size() > 1 ? m_pages.size() : 1;
+
+  info.m_layers.clear();
+  const std::vector<unsigned> *elements = _findListElements(m_block.second.m_layerListId);
+  if (!elements)
+    return;
+  for (unsigned int element : *elements)
+  {
+    auto layerIter = m_layers.find(element);
+    if (layerIter == m_layers.end())
+      continue;
+    librevenge::RVNGPropertyList layer;
+    auto iterString = m_strings.find(layerIter->second.m_nameId);
+    if (iterString != m_strings.end())
+      layer.insert("librevenge:name", iterString->second);
+    layer.insert("librevenge:visible", layerIter->second.m_visibility == 3);
+    info.m_layers.append(layer);
+  }
 }
 
 void libfreehand::FHCollector::_outputLayer(unsigned layerId, librevenge::RVNGDrawingInterface *painter)
@@ -1320,7 +1442,7 @@ void libfreehand::FHCollector::_outputLayer(unsigned layerId, librevenge::RVNGDr
   if (!painter)
     return;
 
-  std::map<unsigned, FHLayer>::const_iterator layerIter = m_layers.find(layerId);
+  auto layerIter = m_layers.find(layerId);
   if (layerIter == m_layers.end())
   {
     FH_DEBUG_MSG(("ERROR: Could not find the referenced layer\n"));
@@ -1345,7 +1467,126 @@ void libfreehand::FHCollector::_outputLayer(unsigned layerId, librevenge::RVNGDr
   }
 
   for (unsigned int element : *elements)
-    _outputSomething(element, painter);
+  {
+    if (_isOnCurrentPage(element))
+      _outputSomething(element, painter);
+  }
+}
+
+void libfreehand::FHCollector::_buildLayerElementBBoxes()
+{
+  // Computed once, in the coordinates of the whole document
+  m_layerElementBBoxes.clear();
+  const std::vector<unsigned> *layers = _findListElements(m_block.second.m_layerListId);
+  if (!layers)
+    return;
+  for (unsigned layerId : *layers)
+  {
+    auto layerIter = m_layers.find(layerId);
+    if (layerIter == m_layers.end() || layerIter->second.m_visibility != 3)
+      continue;
+    const std::vector<unsigned> *elements = _findListElements(layerIter->second.m_elementsId);
+    if (!elements)
+      continue;
+    for (unsigned element : *elements)
+    {
+      if (m_layerElementBBoxes.find(element) == m_layerElementBBoxes.end())
+        _getBBofSomething(element, m_layerElementBBoxes[element]);
+    }
+  }
+}
+
+bool libfreehand::FHCollector::_isOnCurrentPage(unsigned elementId)
+{
+  auto iter = m_layerElementBBoxes.find(elementId);
+  if (iter == m_layerElementBBoxes.end())
+    return true;
+  const FHBoundingBox &bBox = iter->second;
+  // Whatever has no extent cannot be placed, so it goes everywhere
+  if (bBox.m_xmin > bBox.m_xmax || bBox.m_ymin > bBox.m_ymax)
+    return true;
+  return bBox.intersects(m_pageBox);
+}
+
+bool libfreehand::FHCollector::_isCulled(unsigned somethingId)
+{
+  // Contents rendered to SVG have their own coordinates
+  if (!m_culling || !m_fakeTransforms.empty())
+    return false;
+  FHBoundingBox bBox;
+  _getCullingBBofSomething(somethingId, bBox);
+  // Whatever has no extent cannot be placed, so it is kept
+  if (bBox.m_xmin > bBox.m_xmax || bBox.m_ymin > bBox.m_ymax)
+    return false;
+  return !bBox.intersects(m_cullingBox);
+}
+
+void libfreehand::FHCollector::_getCullingBBofSomething(unsigned somethingId, libfreehand::FHBoundingBox &bBox)
+{
+  // A path is not transformed just to be culled. Its own bounding box is
+  // transformed instead, which may keep a path lying just outside.
+  FHBoundingBox localBBox;
+  unsigned xFormId = 0;
+  switch (_getRecordType(somethingId))
+  {
+  case FH_RECORD_PATH:
+  {
+    const FHPath *path = _findPath(somethingId);
+    if (path)
+      xFormId = path->getXFormId();
+    _mergeLocalBBofPath(somethingId, localBBox);
+    break;
+  }
+  case FH_RECORD_COMPOSITE_PATH:
+  {
+    const FHCompositePath *compositePath = _findCompositePath(somethingId);
+    const std::vector<unsigned> *elements = compositePath ? _findListElements(compositePath->m_elementsId) : nullptr;
+    if (!elements || elements->empty())
+      return;
+    // the composed path has the transform of the first one
+    const FHPath *path = _findPath(elements->front());
+    if (path)
+      xFormId = path->getXFormId();
+    for (unsigned element : *elements)
+      _mergeLocalBBofPath(element, localBBox);
+    break;
+  }
+  default:
+    _getBBofSomething(somethingId, bBox);
+    return;
+  }
+  if (localBBox.m_xmin > localBBox.m_xmax || localBBox.m_ymin > localBBox.m_ymax)
+    return;
+
+  const FHTransform trafo = _getCurrentTransform(xFormId);
+  const double xs[] = { localBBox.m_xmin, localBBox.m_xmax, localBBox.m_xmin, localBBox.m_xmax };
+  const double ys[] = { localBBox.m_ymin, localBBox.m_ymin, localBBox.m_ymax, localBBox.m_ymax };
+  for (unsigned i = 0; i < 4; ++i)
+  {
+    double x = xs[i];
+    double y = ys[i];
+    trafo.applyToPoint(x, y);
+    if (x < bBox.m_xmin) bBox.m_xmin = x;
+    if (x > bBox.m_xmax) bBox.m_xmax = x;
+    if (y < bBox.m_ymin) bBox.m_ymin = y;
+    if (y > bBox.m_ymax) bBox.m_ymax = y;
+  }
+}
+
+void libfreehand::FHCollector::_mergeLocalBBofPath(unsigned pathId, libfreehand::FHBoundingBox &bBox)
+{
+  auto iter = m_localPathBBoxes.find(pathId);
+  if (iter == m_localPathBBoxes.end())
+  {
+    FHBoundingBox localBBox;
+    const FHPath *path = _findPath(pathId);
+    if (path && !path->empty())
+      path->getBoundingBox(localBBox.m_xmin, localBBox.m_ymin, localBBox.m_xmax, localBBox.m_ymax);
+    iter = m_localPathBBoxes.insert(std::make_pair(pathId, localBBox)).first;
+  }
+  const FHBoundingBox &localBBox = iter->second;
+  if (localBBox.m_xmin <= localBBox.m_xmax && localBBox.m_ymin <= localBBox.m_ymax)
+    bBox.merge(localBBox);
 }
 
 void libfreehand::FHCollector::_outputCompositePath(const libfreehand::FHCompositePath *compositePath, librevenge::RVNGDrawingInterface *painter)
@@ -1448,35 +1689,10 @@ void libfreehand::FHCollector::_outputTextObject(const libfreehand::FHTextObject
         double yb = startY + height;
         double xc = xa;
         double yc = yb;
-        unsigned xFormId = textObject->m_xFormId;
-        if (xFormId)
-        {
-          const FHTransform *trafo = _findTransform(xFormId);
-          if (trafo)
-          {
-            trafo->applyToPoint(xa, ya);
-            trafo->applyToPoint(xb, yb);
-            trafo->applyToPoint(xc, yc);
-          }
-        }
-        std::stack<FHTransform> groupTransforms(m_currentTransforms);
-        while (!groupTransforms.empty())
-        {
-          groupTransforms.top().applyToPoint(xa, ya);
-          groupTransforms.top().applyToPoint(xb, yb);
-          groupTransforms.top().applyToPoint(xc, yc);
-          groupTransforms.pop();
-        }
-        _normalizePoint(xa, ya);
-        _normalizePoint(xb, yb);
-        _normalizePoint(xc, yc);
-
-        for (std::vector<FHTransform>::const_iterator iter = m_fakeTransforms.begin(); iter != m_fakeTransforms.end(); ++iter)
-        {
-          iter->applyToPoint(xa, ya);
-          iter->applyToPoint(xb, yb);
-          iter->applyToPoint(xc, yc);
-        }
+        const FHTransform trafo = _getCurrentTransform(textObject->m_xFormId);
+        trafo.applyToPoint(xa, ya);
+        trafo.applyToPoint(xb, yb);
+        trafo.applyToPoint(xc, yc);
 
         rotation = atan2(yb-yc, xb-xc);
         finalHeight = sqrt((xc-xa)*(xc-xa) + (yc-ya)*(yc-ya));
@@ -1539,7 +1755,7 @@ void libfreehand::FHCollector::_outputParagraph(const libfreehand::FHParagraph *
   if (!painter || !paragraph)
     return;
   bool paragraphOpened=false;
-  std::map<unsigned, std::vector<unsigned short> >::const_iterator iter = m_textBloks.find(paragraph->m_textBlokId);
+  auto iter = m_textBloks.find(paragraph->m_textBlokId);
   if (iter != m_textBloks.end())
   {
 
@@ -1575,13 +1791,13 @@ void libfreehand::FHCollector::_outputParagraph(const libfreehand::FHParagraph *
 
 void libfreehand::FHCollector::_appendCharacterProperties(librevenge::RVNGPropertyList &propList, unsigned charPropsId)
 {
-  std::map<unsigned, FHCharProperties>::const_iterator iter = m_charProperties.find(charPropsId);
+  auto iter = m_charProperties.find(charPropsId);
   if (iter == m_charProperties.end())
     return;
   const FHCharProperties &charProps = iter->second;
   if (charProps.m_fontNameId)
   {
-    std::map<unsigned, librevenge::RVNGString>::const_iterator iterString = m_strings.find(charProps.m_fontNameId);
+    auto iterString = m_strings.find(charProps.m_fontNameId);
     if (iterString != m_strings.end())
       propList.insert("style:font-name", iterString->second);
   }
@@ -1590,7 +1806,7 @@ void libfreehand::FHCollector::_appendCharacterProperties(librevenge::RVNGProper
     _appendFontProperties(propList, charProps.m_fontId);
   if (charProps.m_textColorId)
   {
-    std::map<unsigned, FHBasicFill>::const_iterator iterBasicFill = m_basicFills.find(charProps.m_textColorId);
+    auto iterBasicFill = m_basicFills.find(charProps.m_textColorId);
     if (iterBasicFill != m_basicFills.end() && iterBasicFill->second.m_colorId)
     {
       librevenge::RVNGString color = getColorString(iterBasicFill->second.m_colorId);
@@ -1601,7 +1817,7 @@ void libfreehand::FHCollector::_appendCharacterProperties(librevenge::RVNGProper
   FHTEffect const *eff=_findTEffect(charProps.m_tEffectId);
   if (eff && eff->m_nameId)
   {
-    std::map<unsigned, librevenge::RVNGString>::const_iterator iterString = m_strings.find(eff->m_nameId);
+    auto iterString = m_strings.find(eff->m_nameId);
     if (iterString != m_strings.end())
     {
       librevenge::RVNGString const &type=iterString->second;
@@ -1659,7 +1875,7 @@ void libfreehand::FHCollector::_appendCharacterProperties(librevenge::RVNGProper
 {
   if (charProps.m_fontNameId)
   {
-    std::map<unsigned, librevenge::RVNGString>::const_iterator iterString = m_strings.find(charProps.m_fontNameId);
+    auto iterString = m_strings.find(charProps.m_fontNameId);
     if (iterString != m_strings.end())
       propList.insert("style:font-name", iterString->second);
   }
@@ -1688,7 +1904,7 @@ void libfreehand::FHCollector::_appendCharacterProperties(librevenge::RVNGProper
   FHTEffect const *eff=_findTEffect(charProps.m_textEffsId);
   if (eff && eff->m_shortNameId)
   {
-    std::map<unsigned, librevenge::RVNGString>::const_iterator iterString = m_strings.find(eff->m_shortNameId);
+    auto iterString = m_strings.find(eff->m_shortNameId);
     if (iterString != m_strings.end())
     {
       librevenge::RVNGString const &type=iterString->second;
@@ -1864,35 +2080,10 @@ void libfreehand::FHCollector::_outputDisplayText(const libfreehand::FHDisplayTe
   double yb = displayText->m_startY + displayText->m_height;
   double xc = xa;
   double yc = yb;
-  unsigned xFormId = displayText->m_xFormId;
-  if (xFormId)
-  {
-    const FHTransform *trafo = _findTransform(xFormId);
-    if (trafo)
-    {
-      trafo->applyToPoint(xa, ya);
-      trafo->applyToPoint(xb, yb);
-      trafo->applyToPoint(xc, yc);
-    }
-  }
-  std::stack<FHTransform> groupTransforms(m_currentTransforms);
-  while (!groupTransforms.empty())
-  {
-    groupTransforms.top().applyToPoint(xa, ya);
-    groupTransforms.top().applyToPoint(xb, yb);
-    groupTransforms.top().applyToPoint(xc, yc);
-    groupTransforms.pop();
-  }
-  _normalizePoint(xa, ya);
-  _normalizePoint(xb, yb);
-  _normalizePoint(xc, yc);
-
-  for (std::vector<FHTransform>::const_iterator iter = m_fakeTransforms.begin(); iter != m_fakeTransforms.end(); ++iter)
-  {
-    iter->applyToPoint(xa, ya);
-    iter->applyToPoint(xb, yb);
-    iter->applyToPoint(xc, yc);
-  }
+  const FHTransform trafo = _getCurrentTransform(displayText->m_xFormId);
+  trafo.applyToPoint(xa, ya);
+  trafo.applyToPoint(xb, yb);
+  trafo.applyToPoint(xc, yc);
 
   double rotation = atan2(yb-yc, xb-xc);
   double height = sqrt((xc-xa)*(xc-xa) + (yc-ya)*(yc-ya));
@@ -2042,44 +2233,17 @@ void libfreehand::FHCollector::_outputImageImport(const FHImageImport *image, li
   if (!painter || !image)
     return;
 
-  librevenge::RVNGPropertyList propList;
-  _appendStrokeProperties(propList, image->m_graphicStyleId);
-  _appendFillProperties(propList, image->m_graphicStyleId);
+  librevenge::RVNGPropertyList propList = _getGraphicStyleProperties(image->m_graphicStyleId);
   double xa = image->m_startX;
   double ya = image->m_startY;
   double xb = image->m_startX + image->m_width;
   double yb = image->m_startY + image->m_height;
   double xc = xa;
   double yc = yb;
-  unsigned xFormId = image->m_xFormId;
-  if (xFormId)
-  {
-    const FHTransform *trafo = _findTransform(xFormId);
-    if (trafo)
-    {
-      trafo->applyToPoint(xa, ya);
-      trafo->applyToPoint(xb, yb);
-      trafo->applyToPoint(xc, yc);
-    }
-  }
-  std::stack<FHTransform> groupTransforms(m_currentTransforms);
-  while (!groupTransforms.empty())
-  {
-    groupTransforms.top().applyToPoint(xa, ya);
-    groupTransforms.top().applyToPoint(xb, yb);
-    groupTransforms.top().applyToPoint(xc, yc);
-    groupTransforms.pop();
-  }
-  _normalizePoint(xa, ya);
-  _normalizePoint(xb, yb);
-  _normalizePoint(xc, yc);
-
-  for (std::vector<FHTransform>::const_iterator iter = m_fakeTransforms.begin(); iter != m_fakeTransforms.end(); ++iter)
-  {
-    iter->applyToPoint(xa, ya);
-    iter->applyToPoint(xb, yb);
-    iter->applyToPoint(xc, yc);
-  }
+  const FHTransform trafo = _getCurrentTransform(image->m_xFormId);
+  trafo.applyToPoint(xa, ya);
+  trafo.applyToPoint(xb, yb);
+  trafo.applyToPoint(xc, yc);
 
   double rotation = atan2(yb-yc, xb-xc);
   double height = sqrt((xc-xa)*(xc-xa) + (yc-ya)*(yc-ya));
@@ -2176,7 +2340,7 @@ void libfreehand::FHCollector::_outputTextRun(const std::vector<unsigned short>
 
 const std::vector<unsigned> *libfreehand::FHCollector::_findListElements(unsigned id)
 {
-  std::map<unsigned, FHList>::const_iterator iter = m_lists.find(id);
+  auto iter = m_lists.find(id);
   if (iter != m_lists.end())
     return &(iter->second.m_elements);
   return nullptr;
@@ -2185,13 +2349,13 @@ const std::vector<unsigned> *libfreehand::FHCollector::_findListElements(unsigne
 
 void libfreehand::FHCollector::_appendFontProperties(librevenge::RVNGPropertyList &propList, unsigned agdFontId)
 {
-  std::map<unsigned, FHAGDFont>::const_iterator iter = m_fonts.find(agdFontId);
+  auto iter = m_fonts.find(agdFontId);
   if (iter == m_fonts.end())
     return;
   const FHAGDFont &font = iter->second;
   if (font.m_fontNameId)
   {
-    std::map<unsigned, librevenge::RVNGString>::const_iterator iterString = m_strings.find(font.m_fontNameId);
+    auto iterString = m_strings.find(font.m_fontNameId);
     if (iterString != m_strings.end())
       propList.insert("style:font-name", iterString->second);
   }
@@ -2202,11 +2366,30 @@ void libfreehand::FHCollector::_appendFontProperties(librevenge::RVNGPropertyLis
     propList.insert("fo:font-style", "italic");
 }
 
+librevenge::RVNGPropertyList libfreehand::FHCollector::_getGraphicStyleProperties(unsigned graphicStyleId)
+{
+  auto iter = m_graphicStyleProperties.find(graphicStyleId);
+  if (iter != m_graphicStyleProperties.end())
+    return iter->second;
+
+  const bool outerCacheable = m_graphicStyleCacheable;
+  m_graphicStyleCacheable = true;
+  librevenge::RVNGPropertyList propList;
+  _appendStrokeProperties(propList, graphicStyleId);
+  _appendFillProperties(propList, graphicStyleId);
+  if (m_graphicStyleCacheable)
+    m_graphicStyleProperties[graphicStyleId] = propList;
+  m_graphicStyleCacheable = outerCacheable;
+  return propList;
+}
+
 void libfreehand::FHCollector::_appendFillProperties(librevenge::RVNGPropertyList &propList, unsigned graphicStyleId)
 {
   if (!propList["draw:fill"])
     propList.insert("draw:fill", "none");
-  if (graphicStyleId && find(m_visitedObjects.begin(), m_visitedObjects.end(), graphicStyleId) == m_visitedObjects.end())
+  if (graphicStyleId && isVisited(m_visitedObjects, graphicStyleId))
+    m_graphicStyleCacheable = false;
+  else if (graphicStyleId)
   {
     const ObjectRecursionGuard guard(m_visitedObjects, graphicStyleId);
     const FHPropList *propertyList = _findPropList(graphicStyleId);
@@ -2264,7 +2447,9 @@ void libfreehand::FHCollector::_appendStrokeProperties(librevenge::RVNGPropertyL
 {
   if (!propList["draw:stroke"])
     propList.insert("draw:stroke", "none");
-  if (graphicStyleId && find(m_visitedObjects.begin(), m_visitedObjects.end(), graphicStyleId) == m_visitedObjects.end())
+  if (graphicStyleId && isVisited(m_visitedObjects, graphicStyleId))
+    m_graphicStyleCacheable = false;
+  else if (graphicStyleId)
   {
     const ObjectRecursionGuard guard(m_visitedObjects, graphicStyleId);
     const FHPropList *propertyList = _findPropList(graphicStyleId);
@@ -2515,11 +2700,14 @@ void libfreehand::FHCollector::_appendTileFill(librevenge::RVNGPropertyList &pro
   if (!tileFill || !(tileFill->m_groupId))
     return;
 
+  // the rendering depends on where the filled object is
+  m_graphicStyleCacheable = false;
+
   const FHTransform *trafo = _findTransform(tileFill->m_xFormId);
   if (trafo)
-    m_currentTransforms.push(*trafo);
+    _pushTransform(*trafo);
   else
-    m_currentTransforms.push(FHTransform());
+    _pushTransform(FHTransform());
 
   FHBoundingBox bBox;
   _getBBofSomething(tileFill->m_groupId, bBox);
@@ -2528,21 +2716,10 @@ void libfreehand::FHCollector::_appendTileFill(librevenge::RVNGPropertyList &pro
     FHTransform fakeTrafo(tileFill->m_scaleX, 0.0, 0.0, tileFill->m_scaleY, - bBox.m_xmin, -bBox.m_ymin);
     m_fakeTransforms.push_back(fakeTrafo);
 
-    librevenge::RVNGStringVector svgOutput;
-    librevenge::RVNGSVGDrawingGenerator generator(svgOutput, "");
-    librevenge::RVNGPropertyList pList;
-    pList.insert("svg:width", tileFill->m_scaleX * (bBox.m_xmax - bBox.m_xmin));
-    pList.insert("svg:height", tileFill->m_scaleY * (bBox.m_ymax - bBox.m_ymin));
-    generator.startPage(pList);
-
-    _outputSomething(tileFill->m_groupId, &generator);
-    generator.endPage();
-    if (!svgOutput.empty() && svgOutput[0].size() > 140) // basically empty svg if it is not fullfilled
+    const librevenge::RVNGBinaryData output = _renderToSVG(tileFill->m_groupId, tileFill->m_scaleX * (bBox.m_xmax - bBox.m_xmin),
+                                                            tileFill->m_scaleY * (bBox.m_ymax - bBox.m_ymin), true);
+    if (!output.empty())
     {
-      const char *header =
-        "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"no\"?>\n<!DOCTYPE svg PUBLIC \"-//W3C//DTD SVG 1.1//EN\" \"http://www.w3.org/Graphics/SVG/1.1/DTD/svg11.dtd\">\n";
-      librevenge::RVNGBinaryData output((const unsigned char *)header, strlen(header));
-      output.append((unsigned char *)svgOutput[0].cstr(), strlen(svgOutput[0].cstr()));
 #if DUMP_TILE_FILLS
       {
         librevenge::RVNGString filename;
@@ -2568,8 +2745,7 @@ void libfreehand::FHCollector::_appendTileFill(librevenge::RVNGPropertyList &pro
     if (!m_fakeTransforms.empty())
       m_fakeTransforms.pop_back();
   }
-  if (!m_currentTransforms.empty())
-    m_currentTransforms.pop();
+  _popTransform();
 }
 
 void libfreehand::FHCollector::_appendPatternFill(librevenge::RVNGPropertyList &propList, const libfreehand::FHPatternFill *patternFill)
@@ -2692,11 +2868,18 @@ void libfreehand::FHCollector::_appendPatternLine(librevenge::RVNGPropertyList &
   propList.insert("svg:stroke-width", patternLine->m_width);
 }
 
+libfreehand::FHRecordType libfreehand::FHCollector::_getRecordType(unsigned id) const
+{
+  if (id >= m_recordIndex.size())
+    return FH_RECORD_NONE;
+  return FHRecordType(m_recordIndex[id].m_type);
+}
+
 const libfreehand::FHPath *libfreehand::FHCollector::_findPath(unsigned id)
 {
   if (!id)
     return nullptr;
-  std::map<unsigned, FHPath>::const_iterator iter = m_paths.find(id);
+  auto iter = m_paths.find(id);
   if (iter != m_paths.end())
     return &(iter->second);
   return nullptr;
@@ -2706,7 +2889,7 @@ const libfreehand::FHNewBlend *libfreehand::FHCollector::_findNewBlend(unsigned
 {
   if (!id)
     return nullptr;
-  std::map<unsigned, FHNewBlend>::const_iterator iter = m_newBlends.find(id);
+  auto iter = m_newBlends.find(id);
   if (iter != m_newBlends.end())
     return &(iter->second);
   return nullptr;
@@ -2716,7 +2899,7 @@ const libfreehand::FHGroup *libfreehand::FHCollector::_findGroup(unsigned id)
 {
   if (!id)
     return nullptr;
-  std::map<unsigned, FHGroup>::const_iterator iter = m_groups.find(id);
+  auto iter = m_groups.find(id);
   if (iter != m_groups.end())
     return &(iter->second);
   return nullptr;
@@ -2726,7 +2909,7 @@ const libfreehand::FHGroup *libfreehand::FHCollector::_findClipGroup(unsigned id
 {
   if (!id)
     return nullptr;
-  std::map<unsigned, FHGroup>::const_iterator iter = m_clipGroups.find(id);
+  auto iter = m_clipGroups.find(id);
   if (iter != m_clipGroups.end())
     return &(iter->second);
   return nullptr;
@@ -2736,7 +2919,7 @@ const libfreehand::FHCompositePath *libfreehand::FHCollector::_findCompositePath
 {
   if (!id)
     return nullptr;
-  std::map<unsigned, FHCompositePath>::const_iterator iter = m_compositePaths.find(id);
+  auto iter = m_compositePaths.find(id);
   if (iter != m_compositePaths.end())
     return &(iter->second);
   return nullptr;
@@ -2746,7 +2929,7 @@ const libfreehand::FHPathText *libfreehand::FHCollector::_findPathText(unsigned
 {
   if (!id)
     return nullptr;
-  std::map<unsigned, FHPathText>::const_iterator iter = m_pathTexts.find(id);
+  auto iter = m_pathTexts.find(id);
   if (iter != m_pathTexts.end())
     return &(iter->second);
   return nullptr;
@@ -2756,7 +2939,7 @@ const libfreehand::FHTextObject *libfreehand::FHCollector::_findTextObject(unsig
 {
   if (!id)
     return nullptr;
-  std::map<unsigned, FHTextObject>::const_iterator iter = m_textObjects.find(id);
+  auto iter = m_textObjects.find(id);
   if (iter != m_textObjects.end())
     return &(iter->second);
   return nullptr;
@@ -2766,7 +2949,7 @@ const libfreehand::FHTransform *libfreehand::FHCollector::_findTransform(unsigne
 {
   if (!id)
     return nullptr;
-  std::map<unsigned, FHTransform>::const_iterator iter = m_transforms.find(id);
+  auto iter = m_transforms.find(id);
   if (iter != m_transforms.end())
     return &(iter->second);
   return nullptr;
@@ -2776,7 +2959,7 @@ const libfreehand::FHTEffect *libfreehand::FHCollector::_findTEffect(unsigned id
 {
   if (!id)
     return nullptr;
-  std::map<unsigned, FHTEffect>::const_iterator iter = m_tEffects.find(id);
+  auto iter = m_tEffects.find(id);
   if (iter != m_tEffects.end())
     return &(iter->second);
   return nullptr;
@@ -2786,7 +2969,7 @@ const libfreehand::FHParagraph *libfreehand::FHCollector::_findParagraph(unsigne
 {
   if (!id)
     return nullptr;
-  std::map<unsigned, FHParagraph>::const_iterator iter = m_paragraphs.find(id);
+  auto iter = m_paragraphs.find(id);
   if (iter != m_paragraphs.end())
     return &(iter->second);
   return nullptr;
@@ -2796,7 +2979,7 @@ const std::vector<libfreehand::FHTab> *libfreehand::FHCollector::_findTabTable(u
 {
   if (!id)
     return nullptr;
-  std::map<unsigned, std::vector<libfreehand::FHTab> >::const_iterator iter = m_tabs.find(id);
+  auto iter = m_tabs.find(id);
   if (iter != m_tabs.end())
     return &(iter->second);
   return nullptr;
@@ -2806,7 +2989,7 @@ const std::vector<unsigned> *libfreehand::FHCollector::_findTStringElements(unsi
 {
   if (!id)
     return nullptr;
-  std::map<unsigned, std::vector<unsigned> >::const_iterator iter = m_tStrings.find(id);
+  auto iter = m_tStrings.find(id);
   if (iter != m_tStrings.end())
     return &(iter->second);
   return nullptr;
@@ -2816,7 +2999,7 @@ const libfreehand::FHPropList *libfreehand::FHCollector::_findPropList(unsigned
 {
   if (!id)
     return nullptr;
-  std::map<unsigned, FHPropList>::const_iterator iter = m_propertyLists.find(id);
+  auto iter = m_propertyLists.find(id);
   if (iter != m_propertyLists.end())
     return &(iter->second);
   return nullptr;
@@ -2826,7 +3009,7 @@ const libfreehand::FHGraphicStyle *libfreehand::FHCollector::_findGraphicStyle(u
 {
   if (!id)
     return nullptr;
-  std::map<unsigned, FHGraphicStyle>::const_iterator iter = m_graphicStyles.find(id);
+  auto iter = m_graphicStyles.find(id);
   if (iter != m_graphicStyles.end())
     return &(iter->second);
   return nullptr;
@@ -2836,7 +3019,7 @@ const libfreehand::FHBasicFill *libfreehand::FHCollector::_findBasicFill(unsigne
 {
   if (!id)
     return nullptr;
-  std::map<unsigned, FHBasicFill>::const_iterator iter = m_basicFills.find(id);
+  auto iter = m_basicFills.find(id);
   if (iter != m_basicFills.end())
     return &(iter->second);
   return nullptr;
@@ -2846,7 +3029,7 @@ const libfreehand::FHLinearFill *libfreehand::FHCollector::_findLinearFill(unsig
 {
   if (!id)
     return nullptr;
-  std::map<unsigned, FHLinearFill>::const_iterator iter = m_linearFills.find(id);
+  auto iter = m_linearFills.find(id);
   if (iter != m_linearFills.end())
     return &(iter->second);
   return nullptr;
@@ -2856,7 +3039,7 @@ const libfreehand::FHLensFill *libfreehand::FHCollector::_findLensFill(unsigned
 {
   if (!id)
     return nullptr;
-  std::map<unsigned, FHLensFill>::const_iterator iter = m_lensFills.find(id);
+  auto iter = m_lensFills.find(id);
   if (iter != m_lensFills.end())
     return &(iter->second);
   return nullptr;
@@ -2866,7 +3049,7 @@ const libfreehand::FHRadialFill *libfreehand::FHCollector::_findRadialFill(unsig
 {
   if (!id)
     return nullptr;
-  std::map<unsigned, FHRadialFill>::const_iterator iter = m_radialFills.find(id);
+  auto iter = m_radialFills.find(id);
   if (iter != m_radialFills.end())
     return &(iter->second);
   return nullptr;
@@ -2876,7 +3059,7 @@ const libfreehand::FHTileFill *libfreehand::FHCollector::_findTileFill(unsigned
 {
   if (!id)
     return nullptr;
-  std::map<unsigned, FHTileFill>::const_iterator iter = m_tileFills.find(id);
+  auto iter = m_tileFills.find(id);
   if (iter != m_tileFills.end())
     return &(iter->second);
   return nullptr;
@@ -2886,7 +3069,7 @@ const libfreehand::FHPatternFill *libfreehand::FHCollector::_findPatternFill(uns
 {
   if (!id)
     return nullptr;
-  std::map<unsigned, FHPatternFill>::const_iterator iter = m_patternFills.find(id);
+  auto iter = m_patternFills.find(id);
   if (iter != m_patternFills.end())
     return &(iter->second);
   return nullptr;
@@ -2896,7 +3079,7 @@ const libfreehand::FHLinePattern *libfreehand::FHCollector::_findLinePattern(uns
 {
   if (!id)
     return nullptr;
-  std::map<unsigned, FHLinePattern>::const_iterator iter = m_linePatterns.find(id);
+  auto iter = m_linePatterns.find(id);
   if (iter != m_linePatterns.end())
     return &(iter->second);
   return nullptr;
@@ -2906,7 +3089,7 @@ const libfreehand::FHPath *libfreehand::FHCollector::_findArrowPath(unsigned id)
 {
   if (!id)
     return nullptr;
-  std::map<unsigned, FHPath>::const_iterator iter = m_arrowPaths.find(id);
+  auto iter = m_arrowPaths.find(id);
   if (iter != m_arrowPaths.end())
     return &(iter->second);
   return nullptr;
@@ -2916,7 +3099,7 @@ const libfreehand::FHBasicLine *libfreehand::FHCollector::_findBasicLine(unsigne
 {
   if (!id)
     return nullptr;
-  std::map<unsigned, FHBasicLine>::const_iterator iter = m_basicLines.find(id);
+  auto iter = m_basicLines.find(id);
   if (iter != m_basicLines.end())
     return &(iter->second);
   return nullptr;
@@ -2926,7 +3109,7 @@ const libfreehand::FHCustomProc *libfreehand::FHCollector::_findCustomProc(unsig
 {
   if (!id)
     return nullptr;
-  std::map<unsigned, FHCustomProc>::const_iterator iter = m_customProcs.find(id);
+  auto iter = m_customProcs.find(id);
   if (iter != m_customProcs.end())
     return &(iter->second);
   return nullptr;
@@ -2936,7 +3119,7 @@ const libfreehand::FHPatternLine *libfreehand::FHCollector::_findPatternLine(uns
 {
   if (!id)
     return nullptr;
-  std::map<unsigned, FHPatternLine>::const_iterator iter = m_patternLines.find(id);
+  auto iter = m_patternLines.find(id);
   if (iter != m_patternLines.end())
     return &(iter->second);
   return nullptr;
@@ -2946,7 +3129,7 @@ const libfreehand::FHRGBColor *libfreehand::FHCollector::_findRGBColor(unsigned
 {
   if (!id)
     return nullptr;
-  std::map<unsigned, FHRGBColor>::const_iterator iter = m_rgbColors.find(id);
+  auto iter = m_rgbColors.find(id);
   if (iter != m_rgbColors.end())
     return &(iter->second);
   return nullptr;
@@ -2956,7 +3139,7 @@ const libfreehand::FHTintColor *libfreehand::FHCollector::_findTintColor(unsigne
 {
   if (!id)
     return nullptr;
-  std::map<unsigned, FHTintColor>::const_iterator iter = m_tints.find(id);
+  auto iter = m_tints.find(id);
   if (iter != m_tints.end())
     return &(iter->second);
   return nullptr;
@@ -2966,7 +3149,7 @@ const libfreehand::FHDisplayText *libfreehand::FHCollector::_findDisplayText(uns
 {
   if (!id)
     return nullptr;
-  std::map<unsigned, FHDisplayText>::const_iterator iter = m_displayTexts.find(id);
+  auto iter = m_displayTexts.find(id);
   if (iter != m_displayTexts.end())
     return &(iter->second);
   return nullptr;
@@ -2976,7 +3159,7 @@ const libfreehand::FHImageImport *libfreehand::FHCollector::_findImageImport(uns
 {
   if (!id)
     return nullptr;
-  std::map<unsigned, FHImageImport>::const_iterator iter = m_images.find(id);
+  auto iter = m_images.find(id);
   if (iter != m_images.end())
     return &(iter->second);
   return nullptr;
@@ -2986,7 +3169,7 @@ const librevenge::RVNGBinaryData *libfreehand::FHCollector::_findData(unsigned i
 {
   if (!id)
     return nullptr;
-  std::map<unsigned, librevenge::RVNGBinaryData>::const_iterator iter = m_data.find(id);
+  auto iter = m_data.find(id);
   if (iter != m_data.end())
     return &(iter->second);
   return nullptr;
@@ -2996,7 +3179,7 @@ const libfreehand::FHSymbolClass *libfreehand::FHCollector::_findSymbolClass(uns
 {
   if (!id)
     return nullptr;
-  std::map<unsigned, FHSymbolClass>::const_iterator iter = m_symbolClasses.find(id);
+  auto iter = m_symbolClasses.find(id);
   if (iter != m_symbolClasses.end())
     return &(iter->second);
   return nullptr;
@@ -3006,7 +3189,7 @@ const libfreehand::FHSymbolInstance *libfreehand::FHCollector::_findSymbolInstan
 {
   if (!id)
     return nullptr;
-  std::map<unsigned, FHSymbolInstance>::const_iterator iter = m_symbolInstances.find(id);
+  auto iter = m_symbolInstances.find(id);
   if (iter != m_symbolInstances.end())
     return &(iter->second);
   return nullptr;
@@ -3016,7 +3199,7 @@ const libfreehand::FHFilterAttributeHolder *libfreehand::FHCollector::_findFilte
 {
   if (!id)
     return nullptr;
-  std::map<unsigned, FHFilterAttributeHolder>::const_iterator iter = m_filterAttributeHolders.find(id);
+  auto iter = m_filterAttributeHolders.find(id);
   if (iter != m_filterAttributeHolders.end())
     return &(iter->second);
   return nullptr;
@@ -3026,7 +3209,7 @@ const std::vector<libfreehand::FHColorStop> *libfreehand::FHCollector::_findMult
 {
   if (!id)
     return nullptr;
-  std::map<unsigned, std::vector<libfreehand::FHColorStop> >::const_iterator iter = m_multiColorLists.find(id);
+  auto iter = m_multiColorLists.find(id);
   if (iter != m_multiColorLists.end())
     return &(iter->second);
   return nullptr;
@@ -3036,7 +3219,7 @@ const double *libfreehand::FHCollector::_findOpacityFilter(unsigned id)
 {
   if (!id)
     return nullptr;
-  std::map<unsigned, double>::const_iterator iter = m_opacityFilters.find(id);
+  auto iter = m_opacityFilters.find(id);
   if (iter != m_opacityFilters.end())
     return &(iter->second);
   return nullptr;
@@ -3046,7 +3229,7 @@ const libfreehand::FWShadowFilter *libfreehand::FHCollector::_findFWShadowFilter
 {
   if (!id)
     return nullptr;
-  std::map<unsigned, FWShadowFilter>::const_iterator iter = m_shadowFilters.find(id);
+  auto iter = m_shadowFilters.find(id);
   if (iter != m_shadowFilters.end())
     return &(iter->second);
   return nullptr;
@@ -3056,7 +3239,7 @@ const libfreehand::FWGlowFilter *libfreehand::FHCollector::_findFWGlowFilter(uns
 {
   if (!id)
     return nullptr;
-  std::map<unsigned, FWGlowFilter>::const_iterator iter = m_glowFilters.find(id);
+  auto iter = m_glowFilters.find(id);
   if (iter != m_glowFilters.end())
     return &(iter->second);
   return nullptr;
@@ -3067,7 +3250,7 @@ unsigned libfreehand::FHCollector::_findStrokeId(const libfreehand::FHGraphicSty
   unsigned listId = graphicStyle.m_attrId;
   if (!listId)
     return 0;
-  std::map<unsigned, FHList>::const_iterator iter = m_lists.find(listId);
+  auto iter = m_lists.find(listId);
   if (iter == m_lists.end())
     return 0;
   unsigned strokeId = 0;
@@ -3085,7 +3268,7 @@ unsigned libfreehand::FHCollector::_findFillId(const libfreehand::FHGraphicStyle
   unsigned listId = graphicStyle.m_attrId;
   if (!listId)
     return 0;
-  std::map<unsigned, FHList>::const_iterator iter = m_lists.find(listId);
+  auto iter = m_lists.find(listId);
   if (iter == m_lists.end())
     return 0;
   unsigned fillId = 0;
@@ -3106,7 +3289,7 @@ const libfreehand::FHFilterAttributeHolder *libfreehand::FHCollector::_findFilte
   unsigned listId = graphicStyle.m_attrId;
   if (!listId)
     return nullptr;
-  std::map<unsigned, FHList>::const_iterator iter = m_lists.find(listId);
+  auto iter = m_lists.find(listId);
   if (iter == m_lists.end())
     return nullptr;
   for (unsigned int element : iter->second.m_elements)
@@ -3124,7 +3307,7 @@ unsigned libfreehand::FHCollector::_findValueFromAttribute(unsigned id)
 {
   if (!id)
     return 0;
-  std::map<unsigned, FHAttributeHolder>::const_iterator iter = m_attributeHolders.find(id);
+  auto iter = m_attributeHolders.find(id);
   if (iter == m_attributeHolders.end())
     return 0;
   unsigned value = 0;
@@ -3137,35 +3320,106 @@ unsigned libfreehand::FHCollector::_findValueFromAttribute(unsigned id)
 
 librevenge::RVNGBinaryData libfreehand::FHCollector::getImageData(unsigned id)
 {
-  std::map<unsigned, FHDataList>::const_iterator iter = m_dataLists.find(id);
+  auto cached = m_imageData.find(id);
+  if (cached != m_imageData.end())
+    return cached->second;
+
+  auto iter = m_dataLists.find(id);
   librevenge::RVNGBinaryData data;
   if (iter == m_dataLists.end())
     return data;
-  for (unsigned int element : iter->second.m_elements)
+  if (iter->second.m_elements.size() == 1)
   {
-    const librevenge::RVNGBinaryData *pData = _findData(element);
+    // nothing to assemble; share the collected chunk
+    const librevenge::RVNGBinaryData *pData = _findData(iter->second.m_elements[0]);
     if (pData)
-      data.append(*pData);
+      data = *pData;
+  }
+  else
+  {
+    if (m_dataChunkUses.empty())
+    {
+      for (auto list = m_dataLists.begin(); list != m_dataLists.end(); ++list)
+      {
+        for (unsigned int element : list->second.m_elements)
+          ++m_dataChunkUses[element];
+      }
+    }
+    for (unsigned int element : iter->second.m_elements)
+    {
+      const librevenge::RVNGBinaryData *pData = _findData(element);
+      if (pData)
+        data.append(*pData);
+    }
+    // The assembled image is kept, so the chunks no other list needs are let go
+    for (unsigned int element : iter->second.m_elements)
+    {
+      if (!--m_dataChunkUses[element] && _findData(element))
+        m_data[element].clear();
+    }
+  }
+
+  // Different data lists can hold the same image; keep only one copy
+  if (!data.empty())
+  {
+    std::vector<librevenge::RVNGBinaryData> &candidates = m_uniqueImageData[hashData(data)];
+    bool found = false;
+    for (auto candidate = candidates.begin(); candidate != candidates.end() && !found; ++candidate)
+    {
+      if (candidate->size() == data.size() && !memcmp(candidate->getDataBuffer(), data.getDataBuffer(), data.size()))
+      {
+        data = *candidate;
+        found = true;
+      }
+    }
+    if (!found)
+      candidates.push_back(data);
   }
+  m_imageData[id] = data;
   return data;
 }
 
-librevenge::RVNGString libfreehand::FHCollector::getColorString(unsigned id, double tintVal)
+void libfreehand::FHCollector::_buildColorTable()
 {
-  FHRGBColor col;
-  const FHRGBColor *color = _findRGBColor(id);
-  if (color)
-    col=*color;
-  else
+  m_colorTable.resize(m_rgbColors.size() + m_tints.size());
+  std::vector<ResolvedColor>::iterator entry = m_colorTable.begin();
+  for (auto iter = m_rgbColors.begin(); iter != m_rgbColors.end(); ++iter, ++entry)
+    entry->m_color = iter->second;
+  for (auto iter = m_tints.begin(); iter != m_tints.end(); ++iter, ++entry)
+    entry->m_color = getRGBFromTint(iter->second);
+  for (auto &color : m_colorTable)
+  {
+    color.m_rgb = ((unsigned)(color.m_color.m_red & 0xff00) << 8)|((unsigned)color.m_color.m_green & 0xff00)|((unsigned)color.m_color.m_blue >> 8);
+    color.m_string = _getColorString(color.m_color);
+  }
+}
+
+const libfreehand::FHCollector::ResolvedColor *libfreehand::FHCollector::_findResolvedColor(unsigned id)
+{
+  if (m_colorTable.size() != m_rgbColors.size() + m_tints.size())
+    _buildColorTable();
+  // The table holds the RGB colors, followed by the tints, in the order
+  // of their stores
+  switch (_getRecordType(id))
   {
-    const FHTintColor *tint = _findTintColor(id);
-    if (!tint)
-      return librevenge::RVNGString();
-    col=getRGBFromTint(*tint);
+  case FH_RECORD_RGB_COLOR:
+    return &m_colorTable[m_recordIndex[id].m_index];
+  case FH_RECORD_TINT_COLOR:
+    return &m_colorTable[m_rgbColors.size() + m_recordIndex[id].m_index];
+  default:
+    return nullptr;
   }
+}
+
+librevenge::RVNGString libfreehand::FHCollector::getColorString(unsigned id, double tintVal)
+{
+  const ResolvedColor *color = _findResolvedColor(id);
+  if (!color)
+    return librevenge::RVNGString();
   if (tintVal<=0 || tintVal>=1)
-    return _getColorString(col);
+    return color->m_string;
 
+  const FHRGBColor &col = color->m_color;
   FHRGBColor finalColor;
   finalColor.m_red = col.m_red * tintVal + (1 - tintVal) * 65536;
   finalColor.m_green = col.m_green * tintVal + (1 - tintVal) * 65536;
@@ -3226,18 +3480,9 @@ void libfreehand::FHCollector::_generateBitmapFromPattern(librevenge::RVNGBinary
   unsigned foreground = 0x000000; // Initialize to black and override after
   unsigned background = 0xffffff; // Initialize to white, since that is Freehand behaviour even if overlapping other colors
 
-  const FHRGBColor *color = _findRGBColor(colorId);
+  const ResolvedColor *color = _findResolvedColor(colorId);
   if (color)
-    foreground = ((unsigned)(color->m_red & 0xff00) << 8)|((unsigned)color->m_green & 0xff00)|((unsigned)color->m_blue >> 8);
-  else
-  {
-    const FHTintColor *tintColor = _findTintColor(colorId);
-    if (tintColor)
-    {
-      FHRGBColor rgbColor = getRGBFromTint(*tintColor);
-      foreground = ((unsigned)(rgbColor.m_red & 0xff00) << 8)|((unsigned)rgbColor.m_green & 0xff00)|((unsigned)rgbColor.m_blue >> 8);
-    }
-  }
+    foreground = color->m_rgb;
   for (unsigned j = height; j > 0; --j)
   {
     unsigned char c(pattern[j-1]);
@@ -10,18 +10,20 @@
 #ifndef __FHCOLLECTOR_H__
 #define __FHCOLLECTOR_H__
 
-#include <deque>
 #include <map>
-#include <stack>
+#include <boost/cstdint.hpp>
 #include <librevenge/librevenge.h>
 #include "FHCollector.h"
 #include "FHTransform.h"
 #include "FHTypes.h"
 #include "FHPath.h"
+#include "FHRecordStore.h"
 
 namespace libfreehand
 {
 
+struct FHDocumentInfo;
+
 class FHCollector
 {
 public:
@@ -66,6 +68,7 @@ public:
   void collectFWGlowFilter(unsigned recordId, const FWGlowFilter &filter);
 
   void collectPageInfo(const FHPageInfo &pageInfo);
+  void collectPage(const FHPageInfo &page);
 
   void collectColor(unsigned recordId, const FHRGBColor &color);
   void collectTintColor(unsigned recordId, const FHTintColor &color);
@@ -84,17 +87,52 @@ public:
   void collectSymbolClass(unsigned recordId, const FHSymbolClass &symbolClass);
   void collectSymbolInstance(unsigned recordId, const FHSymbolInstance &symbolInstance);
 
+  // 0-based and inclusive
+  void setPageRange(unsigned firstPage, unsigned lastPage);
+  void setClipRect(double x, double y, double width, double height);
   void outputDrawing(librevenge::RVNGDrawingInterface *painter);
 
+  // for profiling
+  void getBoundingBoxCacheStats(unsigned long &hits, unsigned long &misses) const;
+
+  // Fills in the page size and the layers
+  void getDocumentInfo(FHDocumentInfo &info);
+
+  // The image held by a data list; equal images share one buffer
+  librevenge::RVNGBinaryData getImageData(unsigned id);
+
 private:
+  struct RenderedSVG
+  {
+    RenderedSVG() : m_context(), m_width(0.0), m_height(0.0), m_data() {}
+    FHTransform m_context;
+    double m_width;
+    double m_height;
+    librevenge::RVNGBinaryData m_data;
+  };
+
+  struct ResolvedColor
+  {
+    ResolvedColor() : m_color(), m_rgb(0), m_string() {}
+    FHRGBColor m_color;
+    unsigned m_rgb;
+    librevenge::RVNGString m_string;
+  };
+
   FHCollector(const FHCollector &);
   FHCollector &operator=(const FHCollector &);
 
-  void _normalizePath(FHPath &path);
-  void _normalizePoint(double &x, double &y);
+  const FHPath &_transformPath(const FHPath &path);
+  void _pushTransform(const FHTransform &trafo);
+  void _popTransform();
+  FHTransform _getCurrentTransform(unsigned xFormId);
+  librevenge::RVNGBinaryData _renderToSVG(unsigned somethingId, double width, double height, bool cache);
 
   void _outputPath(const FHPath *path, librevenge::RVNGDrawingInterface *painter);
   void _outputLayer(unsigned layerId, librevenge::RVNGDrawingInterface *painter);
+  void _buildLayerElementBBoxes();
+  bool _isOnCurrentPage(unsigned elementId);
+  bool _isCulled(unsigned somethingId);
   void _outputGroup(const FHGroup *group, librevenge::RVNGDrawingInterface *painter);
   void _outputClipGroup(const FHGroup *group, librevenge::RVNGDrawingInterface *painter);
   void _outputCompositePath(const FHCompositePath *compositePath, librevenge::RVNGDrawingInterface *painter);
@@ -121,6 +159,8 @@ private:
   void _getBBofNewBlend(const FHNewBlend *newBlend,FHBoundingBox &bBox);
   void _getBBofSymbolInstance(const FHSymbolInstance *symbolInstance,FHBoundingBox &bBox);
   void _getBBofSomething(unsigned somethingId,FHBoundingBox &bBox);
+  void _getCullingBBofSomething(unsigned somethingId, FHBoundingBox &bBox);
+  void _mergeLocalBBofPath(unsigned pathId, FHBoundingBox &bBox);
 
   const std::vector<unsigned> *_findListElements(unsigned id);
   void _appendParagraphProperties(librevenge::RVNGPropertyList &propList, unsigned paraPropsId);
@@ -129,6 +169,7 @@ private:
   void _appendCharacterProperties(librevenge::RVNGPropertyList &propList, const FH3CharProperties &charProps);
   void _appendFontProperties(librevenge::RVNGPropertyList &propList, unsigned agdFontId);
   void _appendTabProperties(librevenge::RVNGPropertyList &propList, const FHTab &tab);
+  librevenge::RVNGPropertyList _getGraphicStyleProperties(unsigned graphicStyleId);
   void _appendFillProperties(librevenge::RVNGPropertyList &propList, unsigned graphicStyleId);
   void _appendStrokeProperties(librevenge::RVNGPropertyList &propList, unsigned graphicStyleId);
   void _appendBasicFill(librevenge::RVNGPropertyList &propList, const FHBasicFill *basicFill);
@@ -149,6 +190,7 @@ private:
   void _applyFilter(librevenge::RVNGPropertyList &propList, unsigned filterId);
   const std::vector<unsigned> *_findTStringElements(unsigned id);
 
+  FHRecordType _getRecordType(unsigned id) const;
   const FHPath *_findPath(unsigned id);
   const FHGroup *_findGroup(unsigned id);
   const FHGroup *_findClipGroup(unsigned id);
@@ -183,6 +225,8 @@ private:
   const FWGlowFilter *_findFWGlowFilter(unsigned id);
   const FHFilterAttributeHolder *_findFilterAttributeHolder(unsigned id);
   const librevenge::RVNGBinaryData *_findData(unsigned id);
+  void _buildColorTable();
+  const ResolvedColor *_findResolvedColor(unsigned id);
   librevenge::RVNGString getColorString(unsigned id, double tint=1);
   unsigned _findFillId(const FHGraphicStyle &graphicStyle);
   unsigned _findStrokeId(const FHGraphicStyle &graphicStyle);
@@ -192,68 +236,108 @@ private:
   const FHSymbolInstance *_findSymbolInstance(unsigned id);
   unsigned _findContentId(unsigned graphicStyleId);
   const std::vector<FHColorStop> *_findMultiColorList(unsigned id);
-  librevenge::RVNGBinaryData getImageData(unsigned id);
   FHRGBColor getRGBFromTint(const FHTintColor &tint);
   void _generateBitmapFromPattern(librevenge::RVNGBinaryData &bitmap, unsigned colorId, const std::vector<unsigned char> &pattern);
 
   FHPageInfo m_pageInfo;
+  // Pages of a multi-page document; m_pageInfo spans all of them
+  std::vector<FHPageInfo> m_pages;
+  unsigned m_firstPage;
+  unsigned m_lastPage;
+  bool m_clip;
+  FHBoundingBox m_clipBox;
+  // Objects outside of this box, in page coordinates, are not output
+  bool m_culling;
+  FHBoundingBox m_cullingBox;
+  // For multi-page documents: the layer elements and the current page, in document coordinates
+  std::map<unsigned, FHBoundingBox> m_layerElementBBoxes;
+  FHBoundingBox m_pageBox;
+  // Bounding boxes of paths in their own coordinates, which no context changes
+  std::map<unsigned, FHBoundingBox> m_localPathBBoxes;
   FHTail m_fhTail;
   std::pair<unsigned, FHBlock> m_block;
-  std::map<unsigned, FHTransform> m_transforms;
-  std::map<unsigned, FHPath> m_paths;
-  std::map<unsigned, librevenge::RVNGString> m_strings;
+  FHRecordIndex m_recordIndex;
+  FHRecordStore<FHTransform, FH_RECORD_TRANSFORM> m_transforms;
+  FHRecordStore<FHPath, FH_RECORD_PATH> m_paths;
+  FHRecordStore<librevenge::RVNGString, FH_RECORD_STRING> m_strings;
   std::map<librevenge::RVNGString, unsigned> m_names;
-  std::map<unsigned, FHList> m_lists;
-  std::map<unsigned, FHLayer> m_layers;
-  std::map<unsigned, FHGroup> m_groups;
-  std::map<unsigned, FHGroup> m_clipGroups;
-  std::stack<FHTransform> m_currentTransforms;
+  FHRecordStore<FHList, FH_RECORD_LIST> m_lists;
+  FHRecordStore<FHLayer, FH_RECORD_LAYER> m_layers;
+  FHRecordStore<FHGroup, FH_RECORD_GROUP> m_groups;
+  FHRecordStore<FHGroup, FH_RECORD_CLIP_GROUP> m_clipGroups;
+  // Group transforms, each one already composed with all the enclosing ones
+  std::vector<FHTransform> m_currentTransforms;
   std::vector<FHTransform> m_fakeTransforms;
-  std::map<unsigned, FHCompositePath> m_compositePaths;
-  std::map<unsigned, FHPathText> m_pathTexts;
-  std::map<unsigned, std::vector<unsigned> > m_tStrings;
-  std::map<unsigned, FHAGDFont> m_fonts;
-  std::map<unsigned, FHTEffect> m_tEffects;
-  std::map<unsigned, FHParagraph> m_paragraphs;
-  std::map<unsigned, std::vector<FHTab> > m_tabs;
-  std::map<unsigned, std::vector<unsigned short> > m_textBloks;
-  std::map<unsigned, FHTextObject> m_textObjects;
-  std::map<unsigned, FHCharProperties> m_charProperties;
+  FHRecordStore<FHCompositePath, FH_RECORD_COMPOSITE_PATH> m_compositePaths;
+  FHRecordStore<FHPathText, FH_RECORD_PATH_TEXT> m_pathTexts;
+  FHRecordStore<std::vector<unsigned>, FH_RECORD_TSTRING> m_tStrings;
+  FHRecordStore<FHAGDFont, FH_RECORD_AGD_FONT> m_fonts;
+  FHRecordStore<FHTEffect, FH_RECORD_TEFFECT> m_tEffects;
+  FHRecordStore<FHParagraph, FH_RECORD_PARAGRAPH> m_paragraphs;
+  FHRecordStore<std::vector<FHTab>, FH_RECORD_TAB_TABLE> m_tabs;
+  FHRecordStore<std::vector<unsigned short>, FH_RECORD_TEXT_BLOK> m_textBloks;
+  FHRecordStore<FHTextObject, FH_RECORD_TEXT_OBJECT> m_textObjects;
+  FHRecordStore<FHCharProperties, FH_RECORD_CHAR_PROPERTIES> m_charProperties;
+  // VMpObj records may carry both character and paragraph properties, so
+  // these share their ids with m_charProperties and cannot be in the index.
   std::map<unsigned, FHParagraphProperties> m_paragraphProperties;
-  std::map<unsigned, FHRGBColor> m_rgbColors;
-  std::map<unsigned, FHBasicFill> m_basicFills;
-  std::map<unsigned, FHPropList> m_propertyLists;
-  std::map<unsigned, FHBasicLine> m_basicLines;
-  std::map<unsigned, FHCustomProc> m_customProcs;
-  std::map<unsigned, FHPatternLine> m_patternLines;
-  std::map<unsigned, FHDisplayText> m_displayTexts;
-  std::map<unsigned, FHGraphicStyle> m_graphicStyles;
-  std::map<unsigned, FHAttributeHolder> m_attributeHolders;
-  std::map<unsigned, librevenge::RVNGBinaryData> m_data;
-  std::map<unsigned, FHDataList> m_dataLists;
-  std::map<unsigned, FHImageImport> m_images;
-  std::map<unsigned, std::vector<FHColorStop> > m_multiColorLists;
-  std::map<unsigned, FHLinearFill> m_linearFills;
-  std::map<unsigned, FHTintColor> m_tints;
-  std::map<unsigned, FHLensFill> m_lensFills;
-  std::map<unsigned, FHRadialFill> m_radialFills;
-  std::map<unsigned, FHNewBlend> m_newBlends;
-  std::map<unsigned, FHFilterAttributeHolder> m_filterAttributeHolders;
-  std::map<unsigned, double> m_opacityFilters;
-  std::map<unsigned, FWShadowFilter> m_shadowFilters;
-  std::map<unsigned, FWGlowFilter> m_glowFilters;
-  std::map<unsigned, FHTileFill> m_tileFills;
-  std::map<unsigned, FHSymbolClass> m_symbolClasses;
-  std::map<unsigned, FHSymbolInstance> m_symbolInstances;
-  std::map<unsigned, FHPatternFill> m_patternFills;
-  std::map<unsigned, FHLinePattern> m_linePatterns;
-  std::map<unsigned, FHPath> m_arrowPaths;
+  FHRecordStore<FHRGBColor, FH_RECORD_RGB_COLOR> m_rgbColors;
+  FHRecordStore<FHBasicFill, FH_RECORD_BASIC_FILL> m_basicFills;
+  FHRecordStore<FHPropList, FH_RECORD_PROPERTY_LIST> m_propertyLists;
+  FHRecordStore<FHBasicLine, FH_RECORD_BASIC_LINE> m_basicLines;
+  FHRecordStore<FHCustomProc, FH_RECORD_CUSTOM_PROC> m_customProcs;
+  FHRecordStore<FHPatternLine, FH_RECORD_PATTERN_LINE> m_patternLines;
+  FHRecordStore<FHDisplayText, FH_RECORD_DISPLAY_TEXT> m_displayTexts;
+  FHRecordStore<FHGraphicStyle, FH_RECORD_GRAPHIC_STYLE> m_graphicStyles;
+  FHRecordStore<FHAttributeHolder, FH_RECORD_ATTRIBUTE_HOLDER> m_attributeHolders;
+  FHRecordStore<librevenge::RVNGBinaryData, FH_RECORD_DATA> m_data;
+  FHRecordStore<FHDataList, FH_RECORD_DATA_LIST> m_dataLists;
+  FHRecordStore<FHImageImport, FH_RECORD_IMAGE> m_images;
+  FHRecordStore<std::vector<FHColorStop>, FH_RECORD_MULTI_COLOR_LIST> m_multiColorLists;
+  FHRecordStore<FHLinearFill, FH_RECORD_LINEAR_FILL> m_linearFills;
+  FHRecordStore<FHTintColor, FH_RECORD_TINT_COLOR> m_tints;
+  FHRecordStore<FHLensFill, FH_RECORD_LENS_FILL> m_lensFills;
+  FHRecordStore<FHRadialFill, FH_RECORD_RADIAL_FILL> m_radialFills;
+  FHRecordStore<FHNewBlend, FH_RECORD_NEW_BLEND> m_newBlends;
+  FHRecordStore<FHFilterAttributeHolder, FH_RECORD_FILTER_ATTRIBUTE_HOLDER> m_filterAttributeHolders;
+  FHRecordStore<double, FH_RECORD_OPACITY_FILTER> m_opacityFilters;
+  FHRecordStore<FWShadowFilter, FH_RECORD_SHADOW_FILTER> m_shadowFilters;
+  FHRecordStore<FWGlowFilter, FH_RECORD_GLOW_FILTER> m_glowFilters;
+  FHRecordStore<FHTileFill, FH_RECORD_TILE_FILL> m_tileFills;
+  FHRecordStore<FHSymbolClass, FH_RECORD_SYMBOL_CLASS> m_symbolClasses;
+  FHRecordStore<FHSymbolInstance, FH_RECORD_SYMBOL_INSTANCE> m_symbolInstances;
+  FHRecordStore<FHPatternFill, FH_RECORD_PATTERN_FILL> m_patternFills;
+  FHRecordStore<FHLinePattern, FH_RECORD_LINE_PATTERN> m_linePatterns;
+  FHRecordStore<FHPath, FH_RECORD_ARROW_PATH> m_arrowPaths;
+  FHPath m_scratchPath;
 
   unsigned m_strokeId;
   unsigned m_fillId;
   unsigned m_contentId;
   unsigned m_textBoxNumberId;
-  std::deque<unsigned> m_visitedObjects;
+  std::vector<bool> m_visitedObjects;
+  // Subtrees whose bounding box is being computed
+  std::vector<bool> m_bBoxVisitedObjects;
+  bool m_bBoxCacheable;
+  // Bounding boxes of subtrees, with the transform context they were computed in
+  std::map<unsigned, std::pair<FHTransform, FHBoundingBox> > m_bBoxCache;
+  unsigned long m_bBoxCacheHits;
+  unsigned long m_bBoxCacheMisses;
+  // SVG renderings of tile fills, for each transform context
+  std::map<unsigned, std::vector<RenderedSVG> > m_svgCache;
+  // Cleared when an object is left out for being drawn already
+  bool m_renderComplete;
+  // Assembled images by data list; equal images share one buffer
+  std::map<unsigned, librevenge::RVNGBinaryData> m_imageData;
+  std::map<uint64_t, std::vector<librevenge::RVNGBinaryData> > m_uniqueImageData;
+  // Data lists that still need each data chunk
+  std::map<unsigned, unsigned> m_dataChunkUses;
+  // Stroke and fill properties of graphic styles that do not depend on
+  // the object they are applied to
+  std::map<unsigned, librevenge::RVNGPropertyList> m_graphicStyleProperties;
+  bool m_graphicStyleCacheable;
+  // Final colors of all RGB colors and tints
+  std::vector<ResolvedColor> m_colorTable;
 };
 
 } // namespace libfreehand
@@ -0,0 +1,173 @@
+/* -*- Mode: C++; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/*
+ * This file is part of the libfreehand project.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include <utility>
+
+#include "FHColorConversion.h"
+#include "FHColorProfiles.h"
+
+namespace
+{
+
+// Grid points per channel
+const unsigned FH_LUT_SIZE = 17;
+
+/* Loading the embedded profile and building the transform is costly,
+ * so it is done once. The transform has no one-pixel cache, which
+ * makes it safe to use from several threads at once.
+ */
+class CMYKTransform
+{
+public:
+  static cmsHTRANSFORM get()
+  {
+    static CMYKTransform instance;
+    return instance.m_transform;
+  }
+
+private:
+  CMYKTransform()
+    : m_context(cmsCreateContext(nullptr, nullptr)), m_transform(nullptr)
+  {
+    cmsHPROFILE inProfile  = cmsOpenProfileFromMemTHR(m_context, CMYK_icc, sizeof(CMYK_icc)/sizeof(CMYK_icc[0]));
+    cmsHPROFILE outProfile = cmsCreate_sRGBProfileTHR(m_context);
+
+    if (inProfile && outProfile)
+      m_transform = cmsCreateTransformTHR(m_context, inProfile, TYPE_CMYK_16, outProfile, TYPE_RGB_16, INTENT_PERCEPTUAL, cmsFLAGS_NOCACHE);
+
+    if (inProfile)
+      cmsCloseProfile(inProfile);
+    if (outProfile)
+      cmsCloseProfile(outProfile);
+  }
+
+  ~CMYKTransform()
+  {
+    if (m_transform)
+      cmsDeleteTransform(m_transform);
+    if (m_context)
+      cmsDeleteContext(m_context);
+  }
+
+  CMYKTransform(const CMYKTransform &);
+  CMYKTransform &operator=(const CMYKTransform &);
+
+  cmsContext m_context;
+  cmsHTRANSFORM m_transform;
+};
+
+// Splits a channel value into a grid cell and the position inside it
+void locate(unsigned short value, unsigned &cell, double &fraction)
+{
+  const double position = value * (FH_LUT_SIZE - 1) / 65535.0;
+  cell = unsigned(position);
+  if (cell >= FH_LUT_SIZE - 1)
+    cell = FH_LUT_SIZE - 2;
+  fraction = position - cell;
+}
+
+} // anonymous namespace
+
+cmsHTRANSFORM libfreehand::getCMYKTransform()
+{
+  return CMYKTransform::get();
+}
+
+libfreehand::FHCMYKLookupTable::FHCMYKLookupTable(cmsHTRANSFORM transform)
+  : m_table()
+{
+  if (!transform)
+    return;
+
+  const unsigned count = FH_LUT_SIZE * FH_LUT_SIZE * FH_LUT_SIZE * FH_LUT_SIZE;
+  std::vector<unsigned short> cmyk(4 * count);
+  std::vector<unsigned short>::iterator iter = cmyk.begin();
+  for (unsigned k = 0; k < FH_LUT_SIZE; ++k)
+    for (unsigned y = 0; y < FH_LUT_SIZE; ++y)
+      for (unsigned m = 0; m < FH_LUT_SIZE; ++m)
+        for (unsigned c = 0; c < FH_LUT_SIZE; ++c)
+        {
+          *iter++ = (unsigned short)(c * 65535 / (FH_LUT_SIZE - 1));
+          *iter++ = (unsigned short)(m * 65535 / (FH_LUT_SIZE - 1));
+          *iter++ = (unsigned short)(y * 65535 / (FH_LUT_SIZE - 1));
+          *iter++ = (unsigned short)(k * 65535 / (FH_LUT_SIZE - 1));
+        }
+
+  m_table.resize(3 * count);
+  cmsDoTransform(transform, &cmyk[0], &m_table[0], count);
+}
+
+void libfreehand::FHCMYKLookupTable::convert(const unsigned short *cmyk, unsigned short *rgb, unsigned count) const
+{
+  const unsigned strides[4] =
+  {
+    3, 3 * FH_LUT_SIZE, 3 * FH_LUT_SIZE * FH_LUT_SIZE, 3 * FH_LUT_SIZE * FH_LUT_SIZE * FH_LUT_SIZE
+  };
+
+  for (unsigned i = 0; i < count; ++i, cmyk += 4, rgb += 3)
+  {
+    if (m_table.empty())
+    {
+      rgb[0] = rgb[1] = rgb[2] = 0;
+      continue;
+    }
+
+    unsigned cells[4];
+    double fractions[4];
+    for (unsigned j = 0; j < 4; ++j)
+      locate(cmyk[j], cells[j], fractions[j]);
+
+    // Walk the tetrahedron in C, M and Y: along the axes by decreasing fraction
+    unsigned order[3] = { 0, 1, 2 };
+    if (fractions[order[0]] < fractions[order[1]])
+      std::swap(order[0], order[1]);
+    if (fractions[order[1]] < fractions[order[2]])
+      std::swap(order[1], order[2]);
+    if (fractions[order[0]] < fractions[order[1]])
+      std::swap(order[0], order[1]);
+
+    const unsigned base = cells[0] * strides[0] + cells[1] * strides[1] + cells[2] * strides[2] + cells[3] * strides[3];
+    double result[3];
+    for (unsigned channel = 0; channel < 3; ++channel)
+    {
+      double slices[2];
+      for (unsigned slice = 0; slice < 2; ++slice)
+      {
+        unsigned vertex = base + slice * strides[3] + channel;
+        double value = m_table[vertex];
+        for (unsigned j = 0; j < 3; ++j)
+        {
+          const unsigned next = vertex + strides[order[j]];
+          value += fractions[order[j]] * (double(m_table[next]) - double(m_table[vertex]));
+          vertex = next;
+        }
+        slices[slice] = value;
+      }
+      result[channel] = slices[0] + fractions[3] * (slices[1] - slices[0]);
+    }
+
+    for (unsigned channel = 0; channel < 3; ++channel)
+    {
+      if (result[channel] <= 0.0)
+        rgb[channel] = 0;
+      else if (result[channel] >= 65535.0)
+        rgb[channel] = 65535;
+      else
+        rgb[channel] = (unsigned short)(result[channel] + 0.5);
+    }
+  }
+}
+
+const libfreehand::FHCMYKLookupTable &libfreehand::getCMYKLookupTable()
+{
+  static FHCMYKLookupTable table(getCMYKTransform());
+  return table;
+}
+
+/* vim:set shiftwidth=2 softtabstop=2 expandtab: */
@@ -8,6 +8,8 @@
  */
 
 
+#include <algorithm>
+#include <climits>
 #include <zlib.h>
 #include "FHInternalStream.h"
 #include "libfreehand_utils.h"
@@ -15,79 +17,74 @@
 
 
 #define CHUNK 16384
+#define INFLATE_RATIO_GUESS 4
 
 libfreehand::FHInternalStream::FHInternalStream(librevenge::RVNGInputStream *input, unsigned long size, bool compressed) :
   librevenge::RVNGInputStream(),
   m_offset(0),
-  m_buffer()
+  m_buffer(),
+  m_data(nullptr),
+  m_size(0),
+  m_zstream()
 {
   if (!size)
     return;
 
-  if (!compressed)
-  {
-    unsigned long tmpNumBytesRead = 0;
-    const unsigned char *tmpBuffer = input->read(size, tmpNumBytesRead);
+  unsigned long tmpNumBytesRead = 0;
+  const unsigned char *tmpBuffer = input->read(size, tmpNumBytesRead);
 
-    if (size != tmpNumBytesRead)
-      return;
+  if (size != tmpNumBytesRead)
+    return;
 
+  if (!compressed)
+  {
     m_buffer = std::vector<unsigned char>(size);
     memcpy(&m_buffer[0], tmpBuffer, size);
+    m_data = &m_buffer[0];
+    m_size = size;
+    return;
   }
-  else
-  {
-    int ret;
-    unsigned have;
-    z_stream strm;
-    unsigned char out[CHUNK];
-
-    /* allocate inflate state */
-    strm.zalloc = Z_NULL;
-    strm.zfree = Z_NULL;
-    strm.opaque = Z_NULL;
-    strm.avail_in = 0;
-    strm.next_in = Z_NULL;
-    ret = inflateInit(&strm);
-    if (ret != Z_OK)
-      return;
 
-    unsigned long tmpNumBytesRead = 0;
-    const unsigned char *tmpBuffer = input->read(size, tmpNumBytesRead);
+  // The input's buffer does not have to stay valid after the constructor,
+  // so everything is inflated now. The buffer starts at a guess of the usual
+  // compression ratio and grows whenever inflate runs out of space.
+  m_buffer.resize(std::max<unsigned long>(INFLATE_RATIO_GUESS * size, CHUNK));
+  _startInflate(tmpBuffer, size);
+  _inflate(ULONG_MAX);
+  m_buffer.resize(m_size);
+  m_data = m_size ? &m_buffer[0] : nullptr;
+}
 
-    if (size != tmpNumBytesRead)
-    {
-      (void)inflateEnd(&strm);
-      return;
-    }
+libfreehand::FHInternalStream::FHInternalStream(const unsigned char *data, unsigned long size, bool compressed) :
+  librevenge::RVNGInputStream(),
+  m_offset(0),
+  m_buffer(),
+  m_data(nullptr),
+  m_size(0),
+  m_zstream()
+{
+  if (!data || !size)
+    return;
 
-    strm.avail_in = (uInt)tmpNumBytesRead;
-    strm.next_in = (Bytef *)tmpBuffer;
+  if (compressed)
+    _startInflate(data, size);
+  else
+  {
+    m_data = data;
+    m_size = size;
+  }
+}
 
-    do
-    {
-      strm.avail_out = CHUNK;
-      strm.next_out = out;
-      ret = inflate(&strm, Z_NO_FLUSH);
-      switch (ret)
-      {
-      case Z_NEED_DICT:
-      case Z_DATA_ERROR:
-      case Z_MEM_ERROR:
-        (void)inflateEnd(&strm);
-        m_buffer.clear();
-        return;
-      }
-
-      have = CHUNK - strm.avail_out;
-
-      for (unsigned long i=0; i<have; i++)
-        m_buffer.push_back(out[i]);
+libfreehand::FHInternalStream::~FHInternalStream()
+{
+  if (m_zstream)
+    (void)inflateEnd(m_zstream.get());
+}
 
-    }
-    while (strm.avail_out == 0);
-    (void)inflateEnd(&strm);
-  }
+unsigned long libfreehand::FHInternalStream::getSize()
+{
+  _inflate(ULONG_MAX);
+  return m_size;
 }
 
 const unsigned char *libfreehand::FHInternalStream::read(unsigned long numBytes, unsigned long &numBytesRead)
@@ -99,10 +96,13 @@ const unsigned char *libfreehand::FHInternalStream::read(unsigned long numBytes,
 
   unsigned numBytesToRead;
 
-  if ((m_offset+numBytes) < m_buffer.size())
+  if (m_zstream)
+    _inflate(m_offset + numBytes);
+
+  if ((m_offset+numBytes) < m_size)
     numBytesToRead = numBytes;
   else
-    numBytesToRead = m_buffer.size() - m_offset;
+    numBytesToRead = m_size - m_offset;
 
   numBytesRead = numBytesToRead; // about as paranoid as we can be..
 
@@ -112,7 +112,7 @@ const unsigned char *libfreehand::FHInternalStream::read(unsigned long numBytes,
   long oldOffset = m_offset;
   m_offset += numBytesToRead;
 
-  return &m_buffer[oldOffset];
+  return m_data + oldOffset;
 }
 
 int libfreehand::FHInternalStream::seek(long offset, librevenge::RVNG_SEEK_TYPE seekType)
@@ -122,32 +122,92 @@ int libfreehand::FHInternalStream::seek(long offset, librevenge::RVNG_SEEK_TYPE
   else if (seekType == librevenge::RVNG_SEEK_SET)
     m_offset = offset;
   else if (seekType == librevenge::RVNG_SEEK_END)
-    m_offset = long(static_cast<unsigned long>(m_buffer.size())) + offset;
+  {
+    _inflate(ULONG_MAX);
+    m_offset = long(m_size) + offset;
+  }
 
   if (m_offset < 0)
   {
     m_offset = 0;
     return 1;
   }
-  if ((long)m_offset > (long)m_buffer.size())
+  if (m_zstream && (long)m_offset > (long)m_size)
+    _inflate(m_offset);
+  if ((long)m_offset > (long)m_size)
   {
-    m_offset = m_buffer.size();
+    m_offset = m_size;
     return 1;
   }
 
   return 0;
 }
 
-long libfreehand::FHInternalStream::tell()
-{
-  return m_offset;
-}
-
 bool libfreehand::FHInternalStream::isEnd()
 {
-  if ((long)m_offset >= (long)m_buffer.size())
+  if (m_zstream && (long)m_offset >= (long)m_size)
+    _inflate(m_offset + 1);
+  if ((long)m_offset >= (long)m_size)
     return true;
 
   return false;
 }
+const unsigned char *libfreehand::FHInternalStream::_fetchSlow(unsigned long numBytes)
+{
+  if (m_zstream)
+    _inflate(m_offset + numBytes);
+  if ((unsigned long)m_offset + numBytes <= m_size)
+    return fetch(numBytes);
+
+  // consume the rest, as a short read() would
+  m_offset = m_size;
+  FH_DEBUG_MSG(("Throwing EndOfStreamException\n"));
+  throw EndOfStreamException();
+}
+
+void libfreehand::FHInternalStream::_startInflate(const unsigned char *data, unsigned long size)
+{
+  m_zstream.reset(new z_stream());
+  m_zstream->zalloc = Z_NULL;
+  m_zstream->zfree = Z_NULL;
+  m_zstream->opaque = Z_NULL;
+  m_zstream->avail_in = (uInt)size;
+  m_zstream->next_in = (Bytef *)data;
+  if (inflateInit(m_zstream.get()) != Z_OK)
+    m_zstream.reset();
+}
+
+void libfreehand::FHInternalStream::_inflate(unsigned long end)
+{
+  while (m_zstream && m_size < end)
+  {
+    if (m_buffer.size() - m_size < CHUNK)
+      m_buffer.resize(std::max<unsigned long>(2 * m_buffer.size(), CHUNK));
+    // only inflate the window that has been asked for
+    const unsigned long window = std::max<unsigned long>(end - m_size, CHUNK);
+    m_zstream->avail_out = (uInt)std::min<unsigned long>(std::min(m_buffer.size() - m_size, window), UINT_MAX);
+    m_zstream->next_out = &m_buffer[m_size];
+    const int ret = inflate(m_zstream.get(), Z_NO_FLUSH);
+    m_size = m_zstream->next_out - &m_buffer[0];
+    m_data = &m_buffer[0];
+    switch (ret)
+    {
+    case Z_NEED_DICT:
+    case Z_DATA_ERROR:
+    case Z_MEM_ERROR:
+      // the stream ends where the valid data end
+      _finishInflate();
+      return;
+    }
+    if (m_zstream->avail_out != 0)
+      _finishInflate();
+  }
+}
+
+void libfreehand::FHInternalStream::_finishInflate()
+{
+  (void)inflateEnd(m_zstream.get());
+  m_zstream.reset();
+}
+
 /* vim:set shiftwidth=2 softtabstop=2 expandtab: */
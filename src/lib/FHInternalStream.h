@@ -11,18 +11,27 @@
 #ifndef __FHINTERNALSTREAM_H__
 #define __FHINTERNALSTREAM_H__
 
+#include <memory>
 #include <vector>
 
+#include <boost/cstdint.hpp>
+
 #include <librevenge-stream/librevenge-stream.h>
 
+struct z_stream_s;
+
 namespace libfreehand
 {
 
-class FHInternalStream : public librevenge::RVNGInputStream
+class FHInternalStream final : public librevenge::RVNGInputStream
 {
 public:
   FHInternalStream(librevenge::RVNGInputStream *input, unsigned long size, bool compressed=false);
-  ~FHInternalStream() override {}
+  // Wraps data owned by somebody else without copying it; the data must outlive
+  // the stream. Compressed data are only inflated as far as they have been read,
+  // sought or asked for their size.
+  FHInternalStream(const unsigned char *data, unsigned long size, bool compressed=false);
+  ~FHInternalStream() override;
   bool isStructured() override
   {
     return false;
@@ -49,20 +58,77 @@ public:
   }
   const unsigned char *read(unsigned long numBytes, unsigned long &numBytesRead) override;
   int seek(long offset, librevenge::RVNG_SEEK_TYPE seekType) override;
-  long tell() override;
+  long tell() override
+  {
+    return m_offset;
+  }
   bool isEnd() override;
-  unsigned long getSize() const
+  unsigned long getSize();
+
+  // Like read(), but throws EndOfStreamException unless all numBytes are available
+  const unsigned char *fetch(unsigned long numBytes)
   {
-    return m_buffer.size();
+    if ((unsigned long)m_offset + numBytes <= m_size)
+    {
+      const unsigned char *const p = m_data + m_offset;
+      m_offset += numBytes;
+      return p;
+    }
+    return _fetchSlow(numBytes);
   }
 
 private:
-  volatile long m_offset;
+  long m_offset;
   std::vector<unsigned char> m_buffer;
+  const unsigned char *m_data;
+  unsigned long m_size;
+  std::unique_ptr<z_stream_s> m_zstream;
+
+  const unsigned char *_fetchSlow(unsigned long numBytes);
+  void _startInflate(const unsigned char *data, unsigned long size);
+  void _inflate(unsigned long end);
+  void _finishInflate();
+
   FHInternalStream(const FHInternalStream &);
   FHInternalStream &operator=(const FHInternalStream &);
 };
 
+// Big-endian readers for the document data. They bypass the virtual
+// read()/isEnd() pair used by the generic readers in libfreehand_utils.h.
+
+inline uint8_t readU8(FHInternalStream *input)
+{
+  return *input->fetch(1);
+}
+
+inline uint16_t readU16(FHInternalStream *input)
+{
+  const unsigned char *const p = input->fetch(2);
+  return (uint16_t)p[1]|((uint16_t)p[0]<<8);
+}
+
+inline uint32_t readU32(FHInternalStream *input)
+{
+  const unsigned char *const p = input->fetch(4);
+  return (uint32_t)p[3]|((uint32_t)p[2]<<8)
+         |((uint32_t)p[1]<<16)|((uint32_t)p[0]<<24);
+}
+
+inline int8_t readS8(FHInternalStream *input)
+{
+  return (int8_t)readU8(input);
+}
+
+inline int16_t readS16(FHInternalStream *input)
+{
+  return (int16_t)readU16(input);
+}
+
+inline int32_t readS32(FHInternalStream *input)
+{
+  return (int32_t)readU32(input);
+}
+
 } // namespace libfreehand
 
 #endif
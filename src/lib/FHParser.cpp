@@ -8,16 +8,17 @@
  */
 
 #include <algorithm>
+#include <map>
 #include <memory>
+#include <mutex>
 #include <sstream>
 #include <string>
 #include <string.h>
 
 #include <unicode/utf8.h>
 #include <unicode/utf16.h>
-#include <lcms2.h>
 #include "FHCollector.h"
-#include "FHColorProfiles.h"
+#include "FHColorConversion.h"
 #include "FHConstants.h"
 #include "FHInternalStream.h"
 #include "FHParser.h"
@@ -56,28 +57,174 @@ const char *getTokenName(int tokenId)
 
 #endif
 
-} // anonymous namespace
+// A path node: 1 byte, point type, 1 byte, then the node and its two
+// control points as 16.16 fixed point x/y pairs
+const int FH_PATH_NODE_SIZE = 27;
 
-libfreehand::FHParser::FHParser()
-  : m_input(nullptr), m_collector(nullptr), m_version(-1), m_dictionary(),
-    m_records(), m_currentRecord(0), m_pageInfo(), m_colorTransform(nullptr)
+double decodeCoordinate(const unsigned char *p)
+{
+  return (double)(int32_t)((uint32_t)p[3]|((uint32_t)p[2]<<8)
+                           |((uint32_t)p[1]<<16)|((uint32_t)p[0]<<24))/65536.;
+}
+
+// CMYK values are packed into one key as C, M, Y, K, 16 bits each
+uint64_t packCMYK(const unsigned short *cmyk)
+{
+  return ((uint64_t)cmyk[0] << 48) | ((uint64_t)cmyk[1] << 32) | ((uint64_t)cmyk[2] << 16) | (uint64_t)cmyk[3];
+}
+
+void unpackCMYK(uint64_t key, unsigned short *cmyk)
+{
+  cmyk[0] = (unsigned short)(key >> 48);
+  cmyk[1] = (unsigned short)(key >> 32);
+  cmyk[2] = (unsigned short)(key >> 16);
+  cmyk[3] = (unsigned short)key;
+}
+
+// CMYK -> RGB results of the shared lcms transform
+const std::size_t FH_CMYK_CACHE_MAX_SIZE = 0x10000;
+
+std::mutex &getCMYKCacheMutex()
 {
-  cmsHPROFILE inProfile  = cmsOpenProfileFromMem(CMYK_icc, sizeof(CMYK_icc)/sizeof(CMYK_icc[0]));
-  cmsHPROFILE outProfile = cmsCreate_sRGBProfile();
+  static std::mutex cacheMutex;
+  return cacheMutex;
+}
+
+std::map<uint64_t, libfreehand::FHRGBColor> &getCMYKCache()
+{
+  static std::map<uint64_t, libfreehand::FHRGBColor> cache;
+  return cache;
+}
 
-  m_colorTransform = cmsCreateTransform(inProfile, TYPE_CMYK_16, outProfile, TYPE_RGB_16, INTENT_PERCEPTUAL, 0);
+} // anonymous namespace
 
-  cmsCloseProfile(inProfile);
-  cmsCloseProfile(outProfile);
+libfreehand::FHParser::FHParser(const FHParseOptions &options)
+  : m_input(nullptr), m_collector(nullptr), m_version(-1), m_dictionary(),
+    m_recordHandlers(), m_recordLayouts(), m_recordCollected(), m_records(),
+    m_currentRecord(0), m_pageInfo(), m_pages(), m_options(options), m_cmykColors(),
+    m_recordOffsets(), m_tailOffset(0)
+{
 }
 
 libfreehand::FHParser::~FHParser()
 {
-  if (m_colorTransform)
-    cmsDeleteTransform(m_colorTransform);
 }
 
 bool libfreehand::FHParser::parse(librevenge::RVNGInputStream *input, librevenge::RVNGDrawingInterface *painter)
+{
+  std::unique_ptr<FHInternalStream> dataStream(_openDocument(input));
+  if (!dataStream)
+    return false;
+
+  FHCollector contentCollector;
+  parseDocument(dataStream.get(), &contentCollector);
+  contentCollector.setPageRange(m_options.m_firstPage, m_options.m_lastPage);
+  if (m_options.m_clip)
+    contentCollector.setClipRect(m_options.m_clipX, m_options.m_clipY, m_options.m_clipWidth, m_options.m_clipHeight);
+  contentCollector.outputDrawing(painter);
+
+  return true;
+}
+
+const std::vector<libfreehand::FHParser::RecordOffset> &libfreehand::FHParser::getRecordOffsets() const
+{
+  return m_recordOffsets;
+}
+
+bool libfreehand::FHParser::parseFromIndex(librevenge::RVNGInputStream *input, librevenge::RVNGDrawingInterface *painter)
+{
+  // nothing has been indexed yet
+  if (m_version < 0)
+    return false;
+  std::unique_ptr<FHInternalStream> dataStream(_openDocument(input));
+  if (!dataStream)
+    return false;
+
+  FHCollector contentCollector;
+  m_cmykColors.clear();
+  m_pages.clear();
+  for (const RecordOffset &record : m_recordOffsets)
+    _parseRecordAt(dataStream.get(), &contentCollector, record);
+  dataStream->seek(m_tailOffset, librevenge::RVNG_SEEK_SET);
+  readFHTail(dataStream.get(), &contentCollector);
+  _finishDocument(&contentCollector);
+  contentCollector.setPageRange(m_options.m_firstPage, m_options.m_lastPage);
+  if (m_options.m_clip)
+    contentCollector.setClipRect(m_options.m_clipX, m_options.m_clipY, m_options.m_clipWidth, m_options.m_clipHeight);
+  contentCollector.outputDrawing(painter);
+
+  return true;
+}
+
+bool libfreehand::FHParser::getInfo(librevenge::RVNGInputStream *input, FHDocumentInfo &info)
+{
+  std::unique_ptr<FHInternalStream> dataStream(_openDocument(input));
+  if (!dataStream)
+    return false;
+
+  info = FHDocumentInfo();
+  info.m_version = m_version;
+  info.m_recordCount = m_records.size();
+
+  for (unsigned short id : m_records)
+  {
+    const int tokenId = id < m_dictionary.size() ? m_dictionary[id] : FH_TOKEN_INVALID;
+    switch (tokenId)
+    {
+    case FH_DISPLAYTEXT:
+    case FH_PATHTEXT:
+    case FH_TEXTCOLUMN:
+    case FH_TEXTINPATH:
+    case FH_TFONPATH:
+      ++info.m_textCount;
+      break;
+    case FH_IMAGEIMPORT:
+    case FH_SWFIMPORT:
+      ++info.m_imageCount;
+      break;
+    // composite paths and blends are made of paths that are counted on their own
+    case FH_ARROWPATH:
+    case FH_OVAL:
+    case FH_PATH:
+    case FH_POLYGONFIGURE:
+    case FH_RECTANGLE:
+      ++info.m_pathCount;
+      break;
+    default:
+      break;
+    }
+  }
+
+  // Only the records that describe the pages and layers are collected
+  for (std::vector<int>::size_type id = 0; id < m_dictionary.size(); ++id)
+  {
+    switch (m_dictionary[id])
+    {
+    case FH_BLOCK:
+    case FH_LAYER:
+    case FH_LIST:
+    case FH_MLIST:
+    case FH_MNAME:
+    case FH_MSTRING:
+    case FH_USTRING:
+    case FH_VMPOBJ:
+      m_recordCollected[id] = true;
+      break;
+    default:
+      m_recordCollected[id] = false;
+    }
+  }
+  FHCollector collector;
+  parseRecords(dataStream.get(), &collector);
+  collector.collectPageInfo(m_pageInfo);
+  for (const FHPageInfo &page : m_pages)
+    collector.collectPage(page);
+  collector.getDocumentInfo(info);
+
+  return true;
+}
+
+std::unique_ptr<libfreehand::FHInternalStream> libfreehand::FHParser::_openDocument(librevenge::RVNGInputStream *input)
 {
   long dataOffset = input->tell();
   unsigned agd = readU32(input);
@@ -86,7 +233,7 @@ bool libfreehand::FHParser::parse(librevenge::RVNGInputStream *input, librevenge
   else if (((agd >> 24) & 0xff) == 'F' && ((agd >> 16) & 0xff) == 'H' && ((agd >> 8) & 0xff) == '3')
     m_version = 3;
   else
-    return false;
+    return std::unique_ptr<FHInternalStream>();
 
   // Skip a dword
   input->seek(4, librevenge::RVNG_SEEK_CUR);
@@ -100,13 +247,14 @@ bool libfreehand::FHParser::parse(librevenge::RVNGInputStream *input, librevenge
 
   input->seek(dataOffset+12, librevenge::RVNG_SEEK_SET);
 
-  FHInternalStream dataStream(input, dataLength-12, m_version >= 9);
-  dataStream.seek(0, librevenge::RVNG_SEEK_SET);
-  FHCollector contentCollector;
-  parseDocument(&dataStream, &contentCollector);
-  contentCollector.outputDrawing(painter);
-
-  return true;
+  // input is not read any more, so the data can be parsed, or inflated, in place
+  unsigned long numBytesRead = 0;
+  const unsigned char *data = input->read(dataLength-12, numBytesRead);
+  if (numBytesRead != dataLength-12)
+    numBytesRead = 0;
+  std::unique_ptr<FHInternalStream> dataStream(new FHInternalStream(data, numBytesRead, m_version >= 9));
+  dataStream->seek(0, librevenge::RVNG_SEEK_SET);
+  return dataStream;
 }
 
 void libfreehand::FHParser::parseDictionary(librevenge::RVNGInputStream *input)
@@ -132,15 +280,28 @@ void libfreehand::FHParser::parseDictionary(librevenge::RVNGInputStream *input)
           f++;
       }
     }
+    if (id >= m_dictionary.size())
+    {
+      m_dictionary.resize(id + 1, FH_TOKEN_INVALID);
+      m_recordHandlers.resize(id + 1, nullptr);
+      m_recordLayouts.resize(id + 1, nullptr);
+      m_recordCollected.resize(id + 1, true);
+    }
     m_dictionary[id] = getTokenId(name.cstr());
+    m_recordHandlers[id] = _getRecordHandler(m_dictionary[id]);
+    m_recordLayouts[id] = _getRecordLayout(m_dictionary[id]);
+    const unsigned category = _getRecordCategory(m_dictionary[id]);
+    m_recordCollected[id] = !category || (category & m_options.m_recordCategories);
   }
 }
 
 void libfreehand::FHParser::parseRecordList(librevenge::RVNGInputStream *input)
 {
+  m_records.clear();
   unsigned count = readU32(input);
   if (count > getRemainingLength(input) / 2)
     count = getRemainingLength(input) / 2;
+  m_records.reserve(count);
   for (unsigned i = 0; i < count; ++i)
   {
     unsigned id = readU16(input);
@@ -149,407 +310,378 @@ void libfreehand::FHParser::parseRecordList(librevenge::RVNGInputStream *input)
   }
 }
 
-void libfreehand::FHParser::parseRecord(librevenge::RVNGInputStream *input, libfreehand::FHCollector *collector, int recordId)
+libfreehand::FHParser::RecordHandler libfreehand::FHParser::_getRecordHandler(int tokenId)
 {
-  FH_DEBUG_MSG(("Parsing record number 0x%x: %s Offset 0x%lx\n", (unsigned)m_currentRecord+1, getTokenName(recordId), input->tell()));
-  switch (recordId)
+  switch (tokenId)
   {
   case FH_AGDFONT:
-    readAGDFont(input, collector);
-    break;
-  case FH_AGDSELECTION:
-    readAGDSelection(input, collector);
-    break;
+    return &FHParser::readAGDFont;
   case FH_ARROWPATH:
-    readArrowPath(input, collector);
-    break;
+    return &FHParser::readArrowPath;
   case FH_ATTRIBUTEHOLDER:
-    readAttributeHolder(input, collector);
-    break;
+    return &FHParser::readAttributeHolder;
   case FH_BASICFILL:
-    readBasicFill(input, collector);
-    break;
+    return &FHParser::readBasicFill;
   case FH_BASICLINE:
-    readBasicLine(input, collector);
-    break;
-  case FH_BENDFILTER:
-    readBendFilter(input, collector);
-    break;
+    return &FHParser::readBasicLine;
   case FH_BLENDOBJECT:
-    readBlendObject(input, collector);
-    break;
+    return &FHParser::readBlendObject;
   case FH_BLOCK:
-    readBlock(input, collector);
-    break;
+    return &FHParser::readBlock;
   case FH_BRUSHLIST:
-    readList(input, collector);
-    break;
+    return &FHParser::readList;
   case FH_BRUSH:
-    readBrush(input, collector);
-    break;
+    return &FHParser::readBrush;
   case FH_BRUSHSTROKE:
-    readBrushStroke(input, collector);
-    break;
+    return &FHParser::readBrushStroke;
   case FH_BRUSHTIP:
-    readBrushTip(input, collector);
-    break;
+    return &FHParser::readBrushTip;
   case FH_CALLIGRAPHICSTROKE:
-    readCalligraphicStroke(input, collector);
-    break;
-  case FH_CHARACTERFILL:
-    readCharacterFill(input, collector);
-    break;
+    return &FHParser::readCalligraphicStroke;
   case FH_CLIPGROUP:
-    readClipGroup(input, collector);
-    break;
-  case FH_COLLECTOR:
-    readCollector(input, collector);
-    break;
+    return &FHParser::readClipGroup;
   case FH_COLOR6:
-    readColor6(input, collector);
-    break;
+    return &FHParser::readColor6;
   case FH_COMPOSITEPATH:
-    readCompositePath(input, collector);
-    break;
+    return &FHParser::readCompositePath;
   case FH_CONEFILL:
-    readConeFill(input, collector);
-    break;
+    return &FHParser::readConeFill;
   case FH_CONNECTORLINE:
-    readConnectorLine(input, collector);
-    break;
-  case FH_CONTENTFILL:
-    readContentFill(input, collector);
-    break;
+    return &FHParser::readConnectorLine;
   case FH_CONTOURFILL:
-    readContourFill(input, collector);
-    break;
+    return &FHParser::readContourFill;
   case FH_CUSTOMPROC:
-    readCustomProc(input, collector);
-    break;
+    return &FHParser::readCustomProc;
   case FH_DATALIST:
-    readDataList(input, collector);
-    break;
+    return &FHParser::readDataList;
   case FH_DATA:
-    readData(input, collector);
-    break;
-  case FH_DATETIME:
-    readDateTime(input, collector);
-    break;
+    return &FHParser::readData;
   case FH_DISPLAYTEXT:
-    readDisplayText(input, collector);
-    break;
-  case FH_DUETFILTER:
-    readDuetFilter(input, collector);
-    break;
-  case FH_ELEMENT:
-    readElement(input, collector);
-    break;
-  case FH_ELEMLIST:
-    readElemList(input, collector);
-    break;
+    return &FHParser::readDisplayText;
   case FH_ELEMPROPLST:
-    readElemPropLst(input, collector);
-    break;
+    return &FHParser::readElemPropLst;
   case FH_ENVELOPE:
-    readEnvelope(input, collector);
-    break;
-  case FH_EXPANDFILTER:
-    readExpandFilter(input, collector);
-    break;
+    return &FHParser::readEnvelope;
   case FH_EXTRUSION:
-    readExtrusion(input, collector);
-    break;
-  case FH_FHDOCHEADER:
-    readFHDocHeader(input, collector);
-    break;
-  case FH_FIGURE:
-    readFigure(input, collector);
-    break;
+    return &FHParser::readExtrusion;
   case FH_FILEDESCRIPTOR:
-    readFileDescriptor(input, collector);
-    break;
+    return &FHParser::readFileDescriptor;
   case FH_FILTERATTRIBUTEHOLDER:
-    readFilterAttributeHolder(input, collector);
-    break;
+    return &FHParser::readFilterAttributeHolder;
   case FH_FWBEVELFILTER:
-    readFWBevelFilter(input, collector);
-    break;
-  case FH_FWBLURFILTER:
-    readFWBlurFilter(input, collector);
-    break;
-  case FH_FWFEATHERFILTER:
-    readFWFeatherFilter(input, collector);
-    break;
+    return &FHParser::readFWBevelFilter;
   case FH_FWGLOWFILTER:
-    readFWGlowFilter(input, collector);
-    break;
+    return &FHParser::readFWGlowFilter;
   case FH_FWSHADOWFILTER:
-    readFWShadowFilter(input, collector);
-    break;
-  case FH_FWSHARPENFILTER:
-    readFWSharpenFilter(input, collector);
-    break;
+    return &FHParser::readFWShadowFilter;
   case FH_GRADIENTMASKFILTER:
-    readGradientMaskFilter(input, collector);
-    break;
+    return &FHParser::readGradientMaskFilter;
   case FH_GRAPHICSTYLE:
-    readGraphicStyle(input, collector);
-    break;
+    return &FHParser::readGraphicStyle;
   case FH_GROUP:
-    readGroup(input, collector);
-    break;
+    return &FHParser::readGroup;
   case FH_GUIDES:
-    readGuides(input, collector);
-    break;
+    return &FHParser::readGuides;
   case FH_HALFTONE:
-    readHalftone(input, collector);
-    break;
-  case FH_IMAGEFILL:
-    readImageFill(input, collector);
-    break;
+    return &FHParser::readHalftone;
   case FH_IMAGEIMPORT:
-    readImageImport(input, collector);
-    break;
-  case FH_IMPORT:
-    readImport(input, collector);
-    break;
+    return &FHParser::readImageImport;
   case FH_LAYER:
-    readLayer(input, collector);
-    break;
+    return &FHParser::readLayer;
   case FH_LENSFILL:
-    readLensFill(input, collector);
-    break;
+    return &FHParser::readLensFill;
   case FH_LINEARFILL:
-    readLinearFill(input, collector);
-    break;
+    return &FHParser::readLinearFill;
   case FH_LINEPAT:
-    readLinePat(input, collector);
-    break;
+    return &FHParser::readLinePat;
   case FH_LINETABLE:
-    readLineTable(input, collector);
-    break;
+    return &FHParser::readLineTable;
   case FH_LIST:
-    readList(input, collector);
-    break;
-  case FH_MASTERPAGEDOCMAN:
-    readMasterPageDocMan(input, collector);
-    break;
-  case FH_MASTERPAGEELEMENT:
-    readMasterPageElement(input, collector);
-    break;
-  case FH_MASTERPAGELAYERELEMENT:
-    readMasterPageLayerElement(input, collector);
-    break;
+    return &FHParser::readList;
   case FH_MASTERPAGELAYERINSTANCE:
-    readMasterPageLayerInstance(input, collector);
-    break;
-  case FH_MASTERPAGESYMBOLCLASS:
-    readMasterPageSymbolClass(input, collector);
-    break;
+    return &FHParser::readMasterPageLayerInstance;
   case FH_MASTERPAGESYMBOLINSTANCE:
-    readMasterPageSymbolInstance(input, collector);
-    break;
+    return &FHParser::readMasterPageSymbolInstance;
   case FH_MDICT:
-    readMDict(input, collector);
-    break;
+    return &FHParser::readMDict;
   case FH_MLIST:
-    readList(input, collector);
-    break;
+    return &FHParser::readList;
   case FH_MNAME:
-    readMName(input, collector);
-    break;
-  case FH_MPOBJECT:
-    readMpObject(input, collector);
-    break;
-  case FH_MQUICKDICT:
-    readMQuickDict(input, collector);
-    break;
+    return &FHParser::readMName;
   case FH_MSTRING:
-    readMString(input, collector);
-    break;
+    return &FHParser::readMString;
   case FH_MULTIBLEND:
-    readMultiBlend(input, collector);
-    break;
+    return &FHParser::readMultiBlend;
   case FH_MULTICOLORLIST:
-    readMultiColorList(input, collector);
-    break;
+    return &FHParser::readMultiColorList;
   case FH_NEWBLEND:
-    readNewBlend(input, collector);
-    break;
+    return &FHParser::readNewBlend;
   case FH_NEWCONTOURFILL:
-    readNewContourFill(input, collector);
-    break;
+    return &FHParser::readNewContourFill;
   case FH_NEWRADIALFILL:
-    readNewRadialFill(input, collector);
-    break;
+    return &FHParser::readNewRadialFill;
   case FH_OPACITYFILTER:
-    readOpacityFilter(input, collector);
-    break;
+    return &FHParser::readOpacityFilter;
   case FH_OVAL:
-    readOval(input, collector);
-    break;
+    return &FHParser::readOval;
   case FH_PANTONECOLOR:
-    readPantoneColor(input, collector);
-    break;
+    return &FHParser::readPantoneColor;
   case FH_PARAGRAPH:
-    readParagraph(input, collector);
-    break;
+    return &FHParser::readParagraph;
   case FH_PATH:
-    readPath(input, collector);
-    break;
+    return &FHParser::readPath;
   case FH_PATHTEXT:
-    readPathText(input, collector);
-    break;
-  case FH_PATHTEXTLINEINFO:
-    readPathTextLineInfo(input, collector);
-    break;
+    return &FHParser::readPathText;
   case FH_PATTERNFILL:
-    readPatternFill(input, collector);
-    break;
+    return &FHParser::readPatternFill;
   case FH_PATTERNLINE:
-    readPatternLine(input, collector);
-    break;
-  case FH_PERSPECTIVEENVELOPE:
-    readPerspectiveEnvelope(input, collector);
-    break;
+    return &FHParser::readPatternLine;
   case FH_PERSPECTIVEGRID:
-    readPerspectiveGrid(input, collector);
-    break;
+    return &FHParser::readPerspectiveGrid;
   case FH_POLYGONFIGURE:
-    readPolygonFigure(input, collector);
-    break;
-  case FH_PROCEDURE:
-    readProcedure(input, collector);
-    break;
+    return &FHParser::readPolygonFigure;
   case FH_PROCESSCOLOR:
-    readProcessColor(input, collector);
-    break;
+    return &FHParser::readProcessColor;
   case FH_PROPLST:
-    readPropLst(input, collector);
-    break;
+    return &FHParser::readPropLst;
   case FH_PSFILL:
-    readPSFill(input, collector);
-    break;
+    return &FHParser::readPSFill;
   case FH_PSLINE:
-    readPSLine(input, collector);
-    break;
+    return &FHParser::readPSLine;
   case FH_RADIALFILL:
-    readRadialFill(input, collector);
-    break;
+    return &FHParser::readRadialFill;
   case FH_RADIALFILLX:
-    readRadialFillX(input, collector);
-    break;
-  case FH_RAGGEDFILTER:
-    readRaggedFilter(input, collector);
-    break;
+    return &FHParser::readRadialFillX;
   case FH_RECTANGLE:
-    readRectangle(input, collector);
-    break;
-  case FH_SKETCHFILTER:
-    readSketchFilter(input, collector);
-    break;
+    return &FHParser::readRectangle;
   case FH_SPOTCOLOR:
-    readSpotColor(input, collector);
-    break;
+    return &FHParser::readSpotColor;
   case FH_SPOTCOLOR6:
-    readSpotColor6(input, collector);
-    break;
+    return &FHParser::readSpotColor6;
   case FH_STYLEPROPLST:
-    readStylePropLst(input, collector);
-    break;
+    return &FHParser::readStylePropLst;
   case FH_SWFIMPORT:
-    readSwfImport(input, collector);
-    break;
+    return &FHParser::readSwfImport;
   case FH_SYMBOLCLASS:
-    readSymbolClass(input, collector);
-    break;
+    return &FHParser::readSymbolClass;
   case FH_SYMBOLINSTANCE:
-    readSymbolInstance(input, collector);
-    break;
+    return &FHParser::readSymbolInstance;
   case FH_SYMBOLLIBRARY:
-    readSymbolLibrary(input, collector);
-    break;
+    return &FHParser::readSymbolLibrary;
   case FH_TABTABLE:
-    readTabTable(input, collector);
-    break;
+    return &FHParser::readTabTable;
   case FH_TAPEREDFILL:
-    readTaperedFill(input, collector);
-    break;
+    return &FHParser::readTaperedFill;
   case FH_TAPEREDFILLX:
-    readTaperedFillX(input, collector);
-    break;
+    return &FHParser::readTaperedFillX;
   case FH_TEFFECT:
-    readTEffect(input, collector);
-    break;
+    return &FHParser::readTEffect;
   case FH_TEXTBLOK:
-    readTextBlok(input, collector);
-    break;
+    return &FHParser::readTextBlok;
   case FH_TEXTCOLUMN:
   case FH_TEXTINPATH:
   case FH_TFONPATH:
-    readTextObject(input, collector);
-    break;
+    return &FHParser::readTextObject;
   case FH_TEXTEFFS:
-    readTextEffs(input, collector);
-    break;
+    return &FHParser::readTextEffs;
   case FH_TILEFILL:
-    readTileFill(input, collector);
-    break;
+    return &FHParser::readTileFill;
   case FH_TINTCOLOR:
-    readTintColor(input, collector);
-    break;
+    return &FHParser::readTintColor;
   case FH_TINTCOLOR6:
-    readTintColor6(input, collector);
-    break;
-  case FH_TRANSFORMFILTER:
-    readTransformFilter(input, collector);
-    break;
+    return &FHParser::readTintColor6;
   case FH_TSTRING:
-    readTString(input, collector);
-    break;
+    return &FHParser::readTString;
   case FH_USTRING:
-    readUString(input, collector);
-    break;
+    return &FHParser::readUString;
   case FH_VDICT:
-    readVDict(input, collector);
-    break;
+    return &FHParser::readVDict;
   case FH_VMPOBJ:
-    readVMpObj(input, collector);
-    break;
+    return &FHParser::readVMpObj;
   case FH_XFORM:
-    readXform(input, collector);
-    break;
+    return &FHParser::readXform;
   default:
-    FH_DEBUG_MSG(("FHParser::parseRecords UNKNOWN TOKEN\n"));
-    return;
+    return nullptr;
+  }
+}
+
+unsigned libfreehand::FHParser::_getRecordCategory(int tokenId)
+{
+  switch (tokenId)
+  {
+  case FH_ARROWPATH:
+  case FH_COMPOSITEPATH:
+  case FH_NEWBLEND:
+  case FH_OVAL:
+  case FH_PATH:
+  case FH_POLYGONFIGURE:
+  case FH_RECTANGLE:
+    return FH_RECORDS_GEOMETRY;
+  case FH_AGDFONT:
+  case FH_DISPLAYTEXT:
+  case FH_PARAGRAPH:
+  case FH_PATHTEXT:
+  case FH_TABTABLE:
+  case FH_TEFFECT:
+  case FH_TEXTBLOK:
+  case FH_TEXTCOLUMN:
+  case FH_TEXTEFFS:
+  case FH_TEXTINPATH:
+  case FH_TFONPATH:
+  case FH_TSTRING:
+  case FH_VMPOBJ:
+    return FH_RECORDS_TEXT;
+  case FH_DATA:
+  case FH_DATALIST:
+  case FH_IMAGEIMPORT:
+  case FH_SWFIMPORT:
+    return FH_RECORDS_IMAGES;
+  case FH_ATTRIBUTEHOLDER:
+  case FH_BASICFILL:
+  case FH_BASICLINE:
+  case FH_CONEFILL:
+  case FH_CONTOURFILL:
+  case FH_CUSTOMPROC:
+  case FH_ELEMPROPLST:
+  case FH_FILTERATTRIBUTEHOLDER:
+  case FH_FWGLOWFILTER:
+  case FH_FWSHADOWFILTER:
+  case FH_GRAPHICSTYLE:
+  case FH_LENSFILL:
+  case FH_LINEARFILL:
+  case FH_LINEPAT:
+  case FH_NEWCONTOURFILL:
+  case FH_NEWRADIALFILL:
+  case FH_OPACITYFILTER:
+  case FH_PATTERNFILL:
+  case FH_PATTERNLINE:
+  case FH_PROPLST:
+  case FH_PSFILL:
+  case FH_PSLINE:
+  case FH_RADIALFILL:
+  case FH_RADIALFILLX:
+  case FH_STYLEPROPLST:
+  case FH_TAPEREDFILL:
+  case FH_TAPEREDFILLX:
+  case FH_TILEFILL:
+    return FH_RECORDS_STYLES;
+  case FH_COLOR6:
+  case FH_MULTICOLORLIST:
+  case FH_PANTONECOLOR:
+  case FH_PROCESSCOLOR:
+  case FH_SPOTCOLOR:
+  case FH_SPOTCOLOR6:
+  case FH_TINTCOLOR:
+  case FH_TINTCOLOR6:
+    return FH_RECORDS_COLORS;
+  default:
+    return 0;
+  }
+}
+
+const libfreehand::FHParser::RecordLayout *libfreehand::FHParser::_getRecordLayout(int tokenId)
+{
+  // The records that are only skipped. Counted ones start with a 16-bit
+  // count of items of m_itemSize bytes, which follow the fixed part.
+  static const RecordLayout layouts[] =
+  {
+    { FH_AGDSELECTION, 6, 4 },
+    { FH_BENDFILTER, 10, 0 },
+    { FH_CHARACTERFILL, 0, 0 },
+    { FH_COLLECTOR, 4, 0 },
+    { FH_CONTENTFILL, 0, 0 },
+    { FH_DATETIME, 14, 0 },
+    { FH_DUETFILTER, 14, 0 },
+    { FH_ELEMENT, 4, 0 },
+    { FH_ELEMLIST, 4, 0 },
+    { FH_EXPANDFILTER, 14, 0 },
+    { FH_FHDOCHEADER, 4, 0 },
+    { FH_FIGURE, 4, 0 },
+    { FH_FWBLURFILTER, 12, 0 },
+    { FH_FWFEATHERFILTER, 8, 0 },
+    { FH_FWSHARPENFILTER, 16, 0 },
+    { FH_IMAGEFILL, 6, 0 },
+    { FH_IMPORT, 34, 0 },
+    { FH_MASTERPAGEDOCMAN, 4, 0 },
+    { FH_MASTERPAGEELEMENT, 14, 0 },
+    { FH_MASTERPAGELAYERELEMENT, 14, 0 },
+    { FH_MASTERPAGESYMBOLCLASS, 12, 0 },
+    { FH_MPOBJECT, 4, 0 },
+    { FH_MQUICKDICT, 5, 4 },
+    { FH_PATHTEXTLINEINFO, 46, 0 }, // osnola: only tried for N0=5, N1=2, N2=5
+    { FH_PERSPECTIVEENVELOPE, 177, 0 },
+    { FH_PROCEDURE, 4, 0 },
+    { FH_RAGGEDFILTER, 16, 0 },
+    { FH_SKETCHFILTER, 11, 0 },
+    { FH_TRANSFORMFILTER, 39, 0 }
+  };
+
+  for (unsigned i = 0; i < sizeof(layouts)/sizeof(layouts[0]); ++i)
+  {
+    if (layouts[i].m_tokenId == tokenId)
+      return &layouts[i];
   }
+  return nullptr;
+}
 
+void libfreehand::FHParser::_skipRecord(FHInternalStream *input, const RecordLayout &layout)
+{
+  unsigned long size = layout.m_size;
+  if (layout.m_itemSize)
+    size += (unsigned long)readU16(input) * layout.m_itemSize;
+  input->seek(size, librevenge::RVNG_SEEK_CUR);
 }
 
-void libfreehand::FHParser::parseRecords(librevenge::RVNGInputStream *input, libfreehand::FHCollector *collector)
+void libfreehand::FHParser::parseRecords(FHInternalStream *input, libfreehand::FHCollector *collector)
 {
+  // The index costs nothing more than noting where each record starts
+  m_recordOffsets.clear();
+  m_recordOffsets.reserve(m_records.size());
   for (m_currentRecord = 0; m_currentRecord < m_records.size() && !input->isEnd(); ++m_currentRecord)
   {
-    std::map<unsigned short, int>::const_iterator iterDict = m_dictionary.find(m_records[m_currentRecord]);
-    if (iterDict != m_dictionary.end())
-    {
-      parseRecord(input, collector, iterDict->second);
-    }
-    else
-    {
-      FH_DEBUG_MSG(("FHParser::parseRecords NO SUCH TOKEN IN DICTIONARY\n"));
-    }
+    const unsigned short id = m_records[m_currentRecord];
+    const int tokenId = id < m_dictionary.size() ? m_dictionary[id] : FH_TOKEN_INVALID;
+    m_recordOffsets.push_back(RecordOffset(unsigned(m_currentRecord + 1), tokenId, input->tell()));
+    _parseRecord(input, collector);
   }
+  m_tailOffset = input->tell();
   readFHTail(input, collector);
 }
 
-void libfreehand::FHParser::parseDocument(librevenge::RVNGInputStream *input, libfreehand::FHCollector *collector)
+void libfreehand::FHParser::parseDocument(FHInternalStream *input, libfreehand::FHCollector *collector)
 {
+  m_cmykColors.clear();
+  m_pages.clear();
   parseRecords(input, collector);
+  _finishDocument(collector);
+}
+
+void libfreehand::FHParser::_finishDocument(libfreehand::FHCollector *collector)
+{
+  _convertCMYKColors(collector);
   collector->collectPageInfo(m_pageInfo);
+  for (const FHPageInfo &page : m_pages)
+    collector->collectPage(page);
+}
+
+void libfreehand::FHParser::_addPage(double minX, double minY, double maxX, double maxY)
+{
+  // Each page may be described by more than one VMpObj
+  for (const FHPageInfo &page : m_pages)
+  {
+    if (FH_ALMOST_ZERO(page.m_minX - minX) && FH_ALMOST_ZERO(page.m_minY - minY)
+        && FH_ALMOST_ZERO(page.m_maxX - maxX) && FH_ALMOST_ZERO(page.m_maxY - maxY))
+      return;
+  }
+  FHPageInfo page;
+  page.m_minX = minX;
+  page.m_minY = minY;
+  page.m_maxX = maxX;
+  page.m_maxY = maxY;
+  m_pages.push_back(page);
 }
 
-void libfreehand::FHParser::readAGDFont(librevenge::RVNGInputStream *input, libfreehand::FHCollector *collector)
+void libfreehand::FHParser::readAGDFont(FHInternalStream *input, libfreehand::FHCollector *collector)
 {
   input->seek(4, librevenge::RVNG_SEEK_CUR);
   unsigned short num = readU16(input);
@@ -581,13 +713,7 @@ void libfreehand::FHParser::readAGDFont(librevenge::RVNGInputStream *input, libf
     collector->collectAGDFont(m_currentRecord+1, font);
 }
 
-void libfreehand::FHParser::readAGDSelection(librevenge::RVNGInputStream *input, libfreehand::FHCollector * /* collector */)
-{
-  unsigned short size = readU16(input);
-  input->seek(6+size*4, librevenge::RVNG_SEEK_CUR);
-}
-
-void libfreehand::FHParser::readArrowPath(librevenge::RVNGInputStream *input, libfreehand::FHCollector *collector)
+void libfreehand::FHParser::readArrowPath(FHInternalStream *input, libfreehand::FHCollector *collector)
 {
   if (m_version > 8)
     input->seek(20, librevenge::RVNG_SEEK_CUR);
@@ -598,57 +724,30 @@ void libfreehand::FHParser::readArrowPath(librevenge::RVNGInputStream *input, li
     input->seek(4, librevenge::RVNG_SEEK_CUR);
   input->seek(4, librevenge::RVNG_SEEK_CUR);
 
-  long endPos=input->tell()+27*numPoints;
-  std::vector<unsigned char> ptrTypes;
-  std::vector<std::vector<std::pair<double, double> > > path;
-  try
-  {
-    for (unsigned short i = 0; i < numPoints  && !input->isEnd(); ++i)
-    {
-      input->seek(1, librevenge::RVNG_SEEK_CUR);
-      ptrTypes.push_back(readU8(input));
-      input->seek(1, librevenge::RVNG_SEEK_CUR);
-      std::vector<std::pair<double, double> > segment;
-      for (unsigned short j = 0; j < 3 && !input->isEnd(); ++j)
-      {
-        double x = _readCoordinate(input);
-        double y = _readCoordinate(input);
-        std::pair<double, double> tmpPoint = std::make_pair(72.*x, 72.*y);
-        segment.push_back(tmpPoint);
-      }
-      if (segment.size() == 3)
-        path.push_back(segment);
-      segment.clear();
-    }
-  }
-  catch (const EndOfStreamException &)
+  long endPos=input->tell()+FH_PATH_NODE_SIZE*numPoints;
+  if (!collector)
   {
-    FH_DEBUG_MSG(("libfreehand::FHParser::readArrowPath:Caught EndOfStreamException, continuing\n"));
+    input->seek(endPos, librevenge::RVNG_SEEK_SET);
+    return;
   }
+  std::vector<double> xs;
+  std::vector<double> ys;
+  _readPathNodes(input, numPoints, xs, ys);
   input->seek(endPos, librevenge::RVNG_SEEK_SET);
 
-  if (path.empty())
+  if (xs.empty())
   {
     FH_DEBUG_MSG(("libfreehand::FHParser::readArrowPath:No path was read\n"));
     return;
   }
 
   FHPath fhPath;
-  fhPath.appendMoveTo(path[0][0].first / 72.0, path[0][0].second / 72.0);
-  size_t i = 0;
-  for (i = 0; i<path.size()-1; ++i)
-    fhPath.appendCubicBezierTo(path[i][2].first / 72.0, path[i][2].second / 72.0,
-                               path[i+1][1].first / 72.0, path[i+1][1].second / 72.0,
-                               path[i+1][0].first / 72.0,  path[i+1][0].second / 72.0);
-  fhPath.appendCubicBezierTo(path[i][2].first / 72.0, path[i][2].second / 72.0,
-                             path[0][1].first / 72.0, path[0][1].second / 72.0,
-                             path[0][0].first / 72.0, path[0][0].second / 72.0);
-  fhPath.appendClosePath();
-  if (collector && !fhPath.empty())
+  _appendPathNodes(fhPath, xs, ys, true);
+  if (!fhPath.empty())
     collector->collectArrowPath(m_currentRecord+1, fhPath);
 }
 
-void libfreehand::FHParser::readAttributeHolder(librevenge::RVNGInputStream *input, libfreehand::FHCollector *collector)
+void libfreehand::FHParser::readAttributeHolder(FHInternalStream *input, libfreehand::FHCollector *collector)
 {
   FHAttributeHolder attributeHolder;
   attributeHolder.m_parentId = _readRecordId(input);
@@ -657,7 +756,7 @@ void libfreehand::FHParser::readAttributeHolder(librevenge::RVNGInputStream *inp
     collector->collectAttributeHolder(m_currentRecord+1, attributeHolder);
 }
 
-void libfreehand::FHParser::readBasicFill(librevenge::RVNGInputStream *input, libfreehand::FHCollector *collector)
+void libfreehand::FHParser::readBasicFill(FHInternalStream *input, libfreehand::FHCollector *collector)
 {
   FHBasicFill fill;
   fill.m_colorId = _readRecordId(input);
@@ -666,7 +765,7 @@ void libfreehand::FHParser::readBasicFill(librevenge::RVNGInputStream *input, li
     collector->collectBasicFill(m_currentRecord+1, fill);
 }
 
-void libfreehand::FHParser::readBasicLine(librevenge::RVNGInputStream *input, libfreehand::FHCollector *collector)
+void libfreehand::FHParser::readBasicLine(FHInternalStream *input, libfreehand::FHCollector *collector)
 {
   FHBasicLine line;
   line.m_colorId = _readRecordId(input);
@@ -680,12 +779,7 @@ void libfreehand::FHParser::readBasicLine(librevenge::RVNGInputStream *input, li
     collector->collectBasicLine(m_currentRecord+1, line);
 }
 
-void libfreehand::FHParser::readBendFilter(librevenge::RVNGInputStream *input, libfreehand::FHCollector * /* collector */)
-{
-  input->seek(10, librevenge::RVNG_SEEK_CUR);
-}
-
-void libfreehand::FHParser::readBlendObject(librevenge::RVNGInputStream *input, libfreehand::FHCollector */*collector*/)
+void libfreehand::FHParser::readBlendObject(FHInternalStream *input, libfreehand::FHCollector */*collector*/)
 {
   // osnola useme
   for (int i=0; i<2; ++i) _readRecordId(input);
@@ -694,7 +788,7 @@ void libfreehand::FHParser::readBlendObject(librevenge::RVNGInputStream *input,
   input->seek(16, librevenge::RVNG_SEEK_CUR);
 }
 
-void libfreehand::FHParser::readBlock(librevenge::RVNGInputStream *input, libfreehand::FHCollector *collector)
+void libfreehand::FHParser::readBlock(FHInternalStream *input, libfreehand::FHCollector *collector)
 {
   unsigned layerListId = 0;
   if (m_version == 10)
@@ -740,20 +834,20 @@ void libfreehand::FHParser::readBlock(librevenge::RVNGInputStream *input, libfre
   }
 }
 
-void libfreehand::FHParser::readBrush(librevenge::RVNGInputStream *input, libfreehand::FHCollector * /* collector */)
+void libfreehand::FHParser::readBrush(FHInternalStream *input, libfreehand::FHCollector * /* collector */)
 {
   _readRecordId(input);
   _readRecordId(input);
 }
 
-void libfreehand::FHParser::readBrushStroke(librevenge::RVNGInputStream *input, libfreehand::FHCollector * /* collector */)
+void libfreehand::FHParser::readBrushStroke(FHInternalStream *input, libfreehand::FHCollector * /* collector */)
 {
   _readRecordId(input);
   _readRecordId(input);
   _readRecordId(input);
 }
 
-void libfreehand::FHParser::readBrushTip(librevenge::RVNGInputStream *input, libfreehand::FHCollector * /* collector */)
+void libfreehand::FHParser::readBrushTip(FHInternalStream *input, libfreehand::FHCollector * /* collector */)
 {
   _readRecordId(input);
   input->seek(60, librevenge::RVNG_SEEK_CUR);
@@ -761,18 +855,14 @@ void libfreehand::FHParser::readBrushTip(librevenge::RVNGInputStream *input, lib
     input->seek(4, librevenge::RVNG_SEEK_CUR);
 }
 
-void libfreehand::FHParser::readCalligraphicStroke(librevenge::RVNGInputStream *input, libfreehand::FHCollector * /* collector */)
+void libfreehand::FHParser::readCalligraphicStroke(FHInternalStream *input, libfreehand::FHCollector * /* collector */)
 {
   _readRecordId(input);
   input->seek(12, librevenge::RVNG_SEEK_CUR);
   _readRecordId(input);
 }
 
-void libfreehand::FHParser::readCharacterFill(librevenge::RVNGInputStream * /* input */, libfreehand::FHCollector * /* collector */)
-{
-}
-
-void libfreehand::FHParser::readClipGroup(librevenge::RVNGInputStream *input, libfreehand::FHCollector *collector)
+void libfreehand::FHParser::readClipGroup(FHInternalStream *input, libfreehand::FHCollector *collector)
 {
   FHGroup group;
   group.m_graphicStyleId = _readRecordId(input);
@@ -786,12 +876,7 @@ void libfreehand::FHParser::readClipGroup(librevenge::RVNGInputStream *input, li
     collector->collectClipGroup(m_currentRecord+1, group);
 }
 
-void libfreehand::FHParser::readCollector(librevenge::RVNGInputStream *input, libfreehand::FHCollector * /* collector */)
-{
-  input->seek(4, librevenge::RVNG_SEEK_CUR);
-}
-
-void libfreehand::FHParser::readColor6(librevenge::RVNGInputStream *input, libfreehand::FHCollector *collector)
+void libfreehand::FHParser::readColor6(FHInternalStream *input, libfreehand::FHCollector *collector)
 {
   unsigned var = readU16(input);
   _readRecordId(input);
@@ -812,7 +897,7 @@ void libfreehand::FHParser::readColor6(librevenge::RVNGInputStream *input, libfr
     collector->collectColor(m_currentRecord+1, color);
 }
 
-void libfreehand::FHParser::readCompositePath(librevenge::RVNGInputStream *input, libfreehand::FHCollector *collector)
+void libfreehand::FHParser::readCompositePath(FHInternalStream *input, libfreehand::FHCollector *collector)
 {
   FHCompositePath compositePath;
   compositePath.m_graphicStyleId = _readRecordId(input);
@@ -825,7 +910,7 @@ void libfreehand::FHParser::readCompositePath(librevenge::RVNGInputStream *input
     collector->collectCompositePath(m_currentRecord+1, compositePath);
 }
 
-void libfreehand::FHParser::readConeFill(librevenge::RVNGInputStream *input, libfreehand::FHCollector *collector)
+void libfreehand::FHParser::readConeFill(FHInternalStream *input, libfreehand::FHCollector *collector)
 {
   /* It is actually a conic gradient that goes from a line on an angle phi
      to a line at an angle phi + M_PI both CW and CCW. We are unable though
@@ -845,18 +930,14 @@ void libfreehand::FHParser::readConeFill(librevenge::RVNGInputStream *input, lib
     collector->collectLinearFill(m_currentRecord+1, fill);
 }
 
-void libfreehand::FHParser::readConnectorLine(librevenge::RVNGInputStream *input, libfreehand::FHCollector * /* collector */)
+void libfreehand::FHParser::readConnectorLine(FHInternalStream *input, libfreehand::FHCollector * /* collector */)
 {
   input->seek(20, librevenge::RVNG_SEEK_CUR);
   unsigned short num = readU16(input);
   input->seek(46+num*27, librevenge::RVNG_SEEK_CUR);
 }
 
-void libfreehand::FHParser::readContentFill(librevenge::RVNGInputStream * /* input */, libfreehand::FHCollector * /* collector */)
-{
-}
-
-void libfreehand::FHParser::readContourFill(librevenge::RVNGInputStream *input, libfreehand::FHCollector *collector)
+void libfreehand::FHParser::readContourFill(FHInternalStream *input, libfreehand::FHCollector *collector)
 {
   if (m_version > 9)
   {
@@ -885,7 +966,7 @@ void libfreehand::FHParser::readContourFill(librevenge::RVNGInputStream *input,
   }
 }
 
-void libfreehand::FHParser::readCustomProc(librevenge::RVNGInputStream *input, libfreehand::FHCollector *collector)
+void libfreehand::FHParser::readCustomProc(FHInternalStream *input, libfreehand::FHCollector *collector)
 {
   FHCustomProc line;
   unsigned short size = readU16(input);
@@ -921,7 +1002,7 @@ void libfreehand::FHParser::readCustomProc(librevenge::RVNGInputStream *input, l
     collector->collectCustomProc(m_currentRecord+1, line);
 }
 
-void libfreehand::FHParser::readDataList(librevenge::RVNGInputStream *input, libfreehand::FHCollector *collector)
+void libfreehand::FHParser::readDataList(FHInternalStream *input, libfreehand::FHCollector *collector)
 {
   unsigned short size = readU16(input);
   FHDataList list;
@@ -936,24 +1017,23 @@ void libfreehand::FHParser::readDataList(librevenge::RVNGInputStream *input, lib
     collector->collectDataList(m_currentRecord+1, list);
 }
 
-void libfreehand::FHParser::readData(librevenge::RVNGInputStream *input, libfreehand::FHCollector *collector)
+void libfreehand::FHParser::readData(FHInternalStream *input, libfreehand::FHCollector *collector)
 {
   unsigned blockSize = readU16(input);
   unsigned dataSize = readU32(input);
+  if (!collector)
+  {
+    input->seek(blockSize*4, librevenge::RVNG_SEEK_CUR);
+    return;
+  }
   unsigned long numBytesRead = 0;
   const unsigned char *buffer = input->read(dataSize, numBytesRead);
   librevenge::RVNGBinaryData data(buffer, numBytesRead);
   input->seek(blockSize*4-dataSize, librevenge::RVNG_SEEK_CUR);
-  if (collector)
-    collector->collectData(m_currentRecord+1, data);
-}
-
-void libfreehand::FHParser::readDateTime(librevenge::RVNGInputStream *input, libfreehand::FHCollector * /* collector */)
-{
-  input->seek(14, librevenge::RVNG_SEEK_CUR);
+  collector->collectData(m_currentRecord+1, data);
 }
 
-void libfreehand::FHParser::readDisplayText(librevenge::RVNGInputStream *input, libfreehand::FHCollector *collector)
+void libfreehand::FHParser::readDisplayText(FHInternalStream *input, libfreehand::FHCollector *collector)
 {
   input->seek(2, librevenge::RVNG_SEEK_CUR);
   FHDisplayText displayText;
@@ -1005,22 +1085,7 @@ void libfreehand::FHParser::readDisplayText(librevenge::RVNGInputStream *input,
   FH_DEBUG_MSG(("FHParser::readDisplayText: %s\n", text.cstr()));
 }
 
-void libfreehand::FHParser::readDuetFilter(librevenge::RVNGInputStream *input, libfreehand::FHCollector * /* collector */)
-{
-  input->seek(14, librevenge::RVNG_SEEK_CUR);
-}
-
-void libfreehand::FHParser::readElement(librevenge::RVNGInputStream *input, libfreehand::FHCollector * /* collector */)
-{
-  input->seek(4, librevenge::RVNG_SEEK_CUR);
-}
-
-void libfreehand::FHParser::readElemList(librevenge::RVNGInputStream *input, libfreehand::FHCollector * /* collector */)
-{
-  input->seek(4, librevenge::RVNG_SEEK_CUR);
-}
-
-void libfreehand::FHParser::readElemPropLst(librevenge::RVNGInputStream *input, libfreehand::FHCollector *collector)
+void libfreehand::FHParser::readElemPropLst(FHInternalStream *input, libfreehand::FHCollector *collector)
 {
   if (m_version > 8)
     input->seek(2, librevenge::RVNG_SEEK_CUR);
@@ -1036,7 +1101,7 @@ void libfreehand::FHParser::readElemPropLst(librevenge::RVNGInputStream *input,
     collector->collectPropList(m_currentRecord+1, propertyList);
 }
 
-void libfreehand::FHParser::readEnvelope(librevenge::RVNGInputStream *input, libfreehand::FHCollector * /* collector */)
+void libfreehand::FHParser::readEnvelope(FHInternalStream *input, libfreehand::FHCollector * /* collector */)
 {
   input->seek(2, librevenge::RVNG_SEEK_CUR);
   _readRecordId(input);
@@ -1049,12 +1114,7 @@ void libfreehand::FHParser::readEnvelope(librevenge::RVNGInputStream *input, lib
   input->seek(4*num2+27*num, librevenge::RVNG_SEEK_CUR);
 }
 
-void libfreehand::FHParser::readExpandFilter(librevenge::RVNGInputStream *input, libfreehand::FHCollector * /* collector */)
-{
-  input->seek(14, librevenge::RVNG_SEEK_CUR);
-}
-
-void libfreehand::FHParser::readExtrusion(librevenge::RVNGInputStream *input, libfreehand::FHCollector * /* collector */)
+void libfreehand::FHParser::readExtrusion(FHInternalStream *input, libfreehand::FHCollector * /* collector */)
 {
   long startPosition = input->tell();
   input->seek(96, librevenge::RVNG_SEEK_CUR);
@@ -1066,12 +1126,7 @@ void libfreehand::FHParser::readExtrusion(librevenge::RVNGInputStream *input, li
   input->seek(92 + _xformCalc(var1, var2) + 2, librevenge::RVNG_SEEK_CUR);
 }
 
-void libfreehand::FHParser::readFHDocHeader(librevenge::RVNGInputStream *input, libfreehand::FHCollector * /* collector */)
-{
-  input->seek(4, librevenge::RVNG_SEEK_CUR);
-}
-
-void libfreehand::FHParser::readFHTail(librevenge::RVNGInputStream *input, libfreehand::FHCollector *collector)
+void libfreehand::FHParser::readFHTail(FHInternalStream *input, libfreehand::FHCollector *collector)
 {
   FH_DEBUG_MSG(("Reading FHTail fake record\n"));
   FHTail fhTail;
@@ -1090,12 +1145,7 @@ void libfreehand::FHParser::readFHTail(librevenge::RVNGInputStream *input, libfr
     collector->collectFHTail(m_currentRecord+1, fhTail);
 }
 
-void libfreehand::FHParser::readFigure(librevenge::RVNGInputStream *input, libfreehand::FHCollector * /* collector */)
-{
-  input->seek(4, librevenge::RVNG_SEEK_CUR);
-}
-
-void libfreehand::FHParser::readFileDescriptor(librevenge::RVNGInputStream *input, libfreehand::FHCollector * /* collector */)
+void libfreehand::FHParser::readFileDescriptor(FHInternalStream *input, libfreehand::FHCollector * /* collector */)
 {
   _readRecordId(input);
   _readRecordId(input);
@@ -1104,7 +1154,7 @@ void libfreehand::FHParser::readFileDescriptor(librevenge::RVNGInputStream *inpu
   input->seek(size, librevenge::RVNG_SEEK_CUR);
 }
 
-void libfreehand::FHParser::readFilterAttributeHolder(librevenge::RVNGInputStream *input, libfreehand::FHCollector *collector)
+void libfreehand::FHParser::readFilterAttributeHolder(FHInternalStream *input, libfreehand::FHCollector *collector)
 {
   FHFilterAttributeHolder filterAttributeHolder;
   filterAttributeHolder.m_parentId = _readRecordId(input);
@@ -1114,23 +1164,13 @@ void libfreehand::FHParser::readFilterAttributeHolder(librevenge::RVNGInputStrea
     collector->collectFilterAttributeHolder(m_currentRecord+1, filterAttributeHolder);
 }
 
-void libfreehand::FHParser::readFWBevelFilter(librevenge::RVNGInputStream *input, libfreehand::FHCollector * /* collector */)
+void libfreehand::FHParser::readFWBevelFilter(FHInternalStream *input, libfreehand::FHCollector * /* collector */)
 {
   _readRecordId(input);
   input->seek(28, librevenge::RVNG_SEEK_CUR);
 }
 
-void libfreehand::FHParser::readFWBlurFilter(librevenge::RVNGInputStream *input, libfreehand::FHCollector * /* collector */)
-{
-  input->seek(12, librevenge::RVNG_SEEK_CUR);
-}
-
-void libfreehand::FHParser::readFWFeatherFilter(librevenge::RVNGInputStream *input, libfreehand::FHCollector * /* collector */)
-{
-  input->seek(8, librevenge::RVNG_SEEK_CUR);
-}
-
-void libfreehand::FHParser::readFWGlowFilter(librevenge::RVNGInputStream *input, libfreehand::FHCollector *collector)
+void libfreehand::FHParser::readFWGlowFilter(FHInternalStream *input, libfreehand::FHCollector *collector)
 {
   FWGlowFilter filter;
   filter.m_colorId = _readRecordId(input);
@@ -1145,7 +1185,7 @@ void libfreehand::FHParser::readFWGlowFilter(librevenge::RVNGInputStream *input,
     collector->collectFWGlowFilter(m_currentRecord+1, filter);
 }
 
-void libfreehand::FHParser::readFWShadowFilter(librevenge::RVNGInputStream *input, libfreehand::FHCollector *collector)
+void libfreehand::FHParser::readFWShadowFilter(FHInternalStream *input, libfreehand::FHCollector *collector)
 {
   FWShadowFilter filter;
   filter.m_colorId = _readRecordId(input);
@@ -1162,17 +1202,12 @@ void libfreehand::FHParser::readFWShadowFilter(librevenge::RVNGInputStream *inpu
     collector->collectFWShadowFilter(m_currentRecord+1, filter);
 }
 
-void libfreehand::FHParser::readFWSharpenFilter(librevenge::RVNGInputStream *input, libfreehand::FHCollector * /* collector */)
-{
-  input->seek(16, librevenge::RVNG_SEEK_CUR);
-}
-
-void libfreehand::FHParser::readGradientMaskFilter(librevenge::RVNGInputStream *input, libfreehand::FHCollector * /* collector */)
+void libfreehand::FHParser::readGradientMaskFilter(FHInternalStream *input, libfreehand::FHCollector * /* collector */)
 {
   _readRecordId(input);
 }
 
-void libfreehand::FHParser::readGraphicStyle(librevenge::RVNGInputStream *input, libfreehand::FHCollector *collector)
+void libfreehand::FHParser::readGraphicStyle(FHInternalStream *input, libfreehand::FHCollector *collector)
 {
   input->seek(2, librevenge::RVNG_SEEK_CUR);
   unsigned short size = readU16(input);
@@ -1185,7 +1220,7 @@ void libfreehand::FHParser::readGraphicStyle(librevenge::RVNGInputStream *input,
     collector->collectGraphicStyle(m_currentRecord+1, graphicStyle);
 }
 
-void libfreehand::FHParser::readGroup(librevenge::RVNGInputStream *input, libfreehand::FHCollector *collector)
+void libfreehand::FHParser::readGroup(FHInternalStream *input, libfreehand::FHCollector *collector)
 {
   FHGroup group;
   group.m_graphicStyleId = _readRecordId(input);
@@ -1199,7 +1234,7 @@ void libfreehand::FHParser::readGroup(librevenge::RVNGInputStream *input, libfre
     collector->collectGroup(m_currentRecord+1, group);
 }
 
-void libfreehand::FHParser::readGuides(librevenge::RVNGInputStream *input, libfreehand::FHCollector * /* collector */)
+void libfreehand::FHParser::readGuides(FHInternalStream *input, libfreehand::FHCollector * /* collector */)
 {
   unsigned short size = readU16(input);
   _readRecordId(input);
@@ -1210,18 +1245,13 @@ void libfreehand::FHParser::readGuides(librevenge::RVNGInputStream *input, libfr
   input->seek(12+size*8, librevenge::RVNG_SEEK_CUR);
 }
 
-void libfreehand::FHParser::readHalftone(librevenge::RVNGInputStream *input, libfreehand::FHCollector * /* collector */)
+void libfreehand::FHParser::readHalftone(FHInternalStream *input, libfreehand::FHCollector * /* collector */)
 {
   _readRecordId(input);
   input->seek(8, librevenge::RVNG_SEEK_CUR);
 }
 
-void libfreehand::FHParser::readImageFill(librevenge::RVNGInputStream *input, libfreehand::FHCollector * /* collector */)
-{
-  input->seek(6, librevenge::RVNG_SEEK_CUR);
-}
-
-void libfreehand::FHParser::readImageImport(librevenge::RVNGInputStream *input, libfreehand::FHCollector *collector)
+void libfreehand::FHParser::readImageImport(FHInternalStream *input, libfreehand::FHCollector *collector)
 {
   FHImageImport image;
   image.m_graphicStyleId = _readRecordId(input);
@@ -1257,12 +1287,7 @@ void libfreehand::FHParser::readImageImport(librevenge::RVNGInputStream *input,
     collector->collectImage(m_currentRecord+1, image);
 }
 
-void libfreehand::FHParser::readImport(librevenge::RVNGInputStream *input, libfreehand::FHCollector * /* collector */)
-{
-  input->seek(34, librevenge::RVNG_SEEK_CUR);
-}
-
-void libfreehand::FHParser::readLayer(librevenge::RVNGInputStream *input, libfreehand::FHCollector *collector)
+void libfreehand::FHParser::readLayer(FHInternalStream *input, libfreehand::FHCollector *collector)
 {
   FHLayer layer;
   layer.m_graphicStyleId = _readRecordId(input);
@@ -1270,14 +1295,14 @@ void libfreehand::FHParser::readLayer(librevenge::RVNGInputStream *input, libfre
     input->seek(4, librevenge::RVNG_SEEK_CUR);
   input->seek(6, librevenge::RVNG_SEEK_CUR);
   layer.m_elementsId = _readRecordId(input);
-  _readRecordId(input);
+  layer.m_nameId = _readRecordId(input);
   layer.m_visibility = readU16(input);
   input->seek(2, librevenge::RVNG_SEEK_CUR);
   if (collector)
     collector->collectLayer(m_currentRecord+1, layer);
 }
 
-void libfreehand::FHParser::readLensFill(librevenge::RVNGInputStream *input, libfreehand::FHCollector *collector)
+void libfreehand::FHParser::readLensFill(FHInternalStream *input, libfreehand::FHCollector *collector)
 {
   FHLensFill fill;
   fill.m_colorId = _readRecordId(input);
@@ -1289,7 +1314,7 @@ void libfreehand::FHParser::readLensFill(librevenge::RVNGInputStream *input, lib
     collector->collectLensFill(m_currentRecord+1, fill);
 }
 
-void libfreehand::FHParser::readLinearFill(librevenge::RVNGInputStream *input, libfreehand::FHCollector *collector)
+void libfreehand::FHParser::readLinearFill(FHInternalStream *input, libfreehand::FHCollector *collector)
 {
   FHLinearFill fill;
   fill.m_color1Id = _readRecordId(input);
@@ -1302,7 +1327,7 @@ void libfreehand::FHParser::readLinearFill(librevenge::RVNGInputStream *input, l
     collector->collectLinearFill(m_currentRecord+1, fill);
 }
 
-void libfreehand::FHParser::readLinePat(librevenge::RVNGInputStream *input, libfreehand::FHCollector *collector)
+void libfreehand::FHParser::readLinePat(FHInternalStream *input, libfreehand::FHCollector *collector)
 {
   unsigned short numStrokes = readU16(input);
   if (!numStrokes && m_version == 8)
@@ -1323,7 +1348,7 @@ void libfreehand::FHParser::readLinePat(librevenge::RVNGInputStream *input, libf
     collector->collectLinePattern(m_currentRecord+1, pattern);
 }
 
-void libfreehand::FHParser::readLineTable(librevenge::RVNGInputStream *input, libfreehand::FHCollector * /* collector */)
+void libfreehand::FHParser::readLineTable(FHInternalStream *input, libfreehand::FHCollector * /* collector */)
 {
   unsigned short tmpSize = readU16(input);
   unsigned short size = readU16(input);
@@ -1336,22 +1361,7 @@ void libfreehand::FHParser::readLineTable(librevenge::RVNGInputStream *input, li
   }
 }
 
-void libfreehand::FHParser::readMasterPageDocMan(librevenge::RVNGInputStream *input, libfreehand::FHCollector * /* collector */)
-{
-  input->seek(4, librevenge::RVNG_SEEK_CUR);
-}
-
-void libfreehand::FHParser::readMasterPageElement(librevenge::RVNGInputStream *input, libfreehand::FHCollector * /* collector */)
-{
-  input->seek(14, librevenge::RVNG_SEEK_CUR);
-}
-
-void libfreehand::FHParser::readMasterPageLayerElement(librevenge::RVNGInputStream *input, libfreehand::FHCollector * /* collector */)
-{
-  input->seek(14, librevenge::RVNG_SEEK_CUR);
-}
-
-void libfreehand::FHParser::readMasterPageLayerInstance(librevenge::RVNGInputStream *input, libfreehand::FHCollector * /* collector */)
+void libfreehand::FHParser::readMasterPageLayerInstance(FHInternalStream *input, libfreehand::FHCollector * /* collector */)
 {
   input->seek(14, librevenge::RVNG_SEEK_CUR);
   unsigned char var1 = readU8(input);
@@ -1359,12 +1369,7 @@ void libfreehand::FHParser::readMasterPageLayerInstance(librevenge::RVNGInputStr
   input->seek(_xformCalc(var1, var2) + 2, librevenge::RVNG_SEEK_CUR);
 }
 
-void libfreehand::FHParser::readMasterPageSymbolClass(librevenge::RVNGInputStream *input, libfreehand::FHCollector * /* collector */)
-{
-  input->seek(12, librevenge::RVNG_SEEK_CUR);
-}
-
-void libfreehand::FHParser::readMasterPageSymbolInstance(librevenge::RVNGInputStream *input, libfreehand::FHCollector * /* collector */)
+void libfreehand::FHParser::readMasterPageSymbolInstance(FHInternalStream *input, libfreehand::FHCollector * /* collector */)
 {
   input->seek(14, librevenge::RVNG_SEEK_CUR);
   unsigned char var1 = readU8(input);
@@ -1372,7 +1377,7 @@ void libfreehand::FHParser::readMasterPageSymbolInstance(librevenge::RVNGInputSt
   input->seek(_xformCalc(var1, var2) + 2, librevenge::RVNG_SEEK_CUR);
 }
 
-void libfreehand::FHParser::readMDict(librevenge::RVNGInputStream *input, libfreehand::FHCollector * /* collector */)
+void libfreehand::FHParser::readMDict(FHInternalStream *input, libfreehand::FHCollector * /* collector */)
 {
   input->seek(2, librevenge::RVNG_SEEK_CUR);
   unsigned short size = readU16(input);
@@ -1384,7 +1389,7 @@ void libfreehand::FHParser::readMDict(librevenge::RVNGInputStream *input, libfre
   }
 }
 
-void libfreehand::FHParser::readList(librevenge::RVNGInputStream *input, libfreehand::FHCollector *collector)
+void libfreehand::FHParser::readList(FHInternalStream *input, libfreehand::FHCollector *collector)
 {
   unsigned short size2 = readU16(input);
   unsigned short size = readU16(input);
@@ -1402,7 +1407,7 @@ void libfreehand::FHParser::readList(librevenge::RVNGInputStream *input, libfree
     collector->collectList(m_currentRecord+1, lst);
 }
 
-void libfreehand::FHParser::readMName(librevenge::RVNGInputStream *input, libfreehand::FHCollector *collector)
+void libfreehand::FHParser::readMName(FHInternalStream *input, libfreehand::FHCollector *collector)
 {
   long startPosition = input->tell();
   unsigned short size = readU16(input);
@@ -1420,18 +1425,7 @@ void libfreehand::FHParser::readMName(librevenge::RVNGInputStream *input, libfre
   }
 }
 
-void libfreehand::FHParser::readMpObject(librevenge::RVNGInputStream *input, libfreehand::FHCollector * /* collector */)
-{
-  input->seek(4, librevenge::RVNG_SEEK_CUR);
-}
-
-void libfreehand::FHParser::readMQuickDict(librevenge::RVNGInputStream *input, libfreehand::FHCollector * /* collector */)
-{
-  unsigned short size = readU16(input);
-  input->seek(5+size*4, librevenge::RVNG_SEEK_CUR);
-}
-
-void libfreehand::FHParser::readMString(librevenge::RVNGInputStream *input, libfreehand::FHCollector *collector)
+void libfreehand::FHParser::readMString(FHInternalStream *input, libfreehand::FHCollector *collector)
 {
   long startPosition = input->tell();
   unsigned short size = readU16(input);
@@ -1446,7 +1440,7 @@ void libfreehand::FHParser::readMString(librevenge::RVNGInputStream *input, libf
     collector->collectString(m_currentRecord+1, str);
 }
 
-void libfreehand::FHParser::readMultiBlend(librevenge::RVNGInputStream *input, libfreehand::FHCollector * /* collector */)
+void libfreehand::FHParser::readMultiBlend(FHInternalStream *input, libfreehand::FHCollector * /* collector */)
 {
   unsigned short size = readU16(input);
   _readRecordId(input);
@@ -1457,7 +1451,7 @@ void libfreehand::FHParser::readMultiBlend(librevenge::RVNGInputStream *input, l
   input->seek(32 + size*6, librevenge::RVNG_SEEK_CUR);
 }
 
-void libfreehand::FHParser::readMultiColorList(librevenge::RVNGInputStream *input, libfreehand::FHCollector *collector)
+void libfreehand::FHParser::readMultiColorList(FHInternalStream *input, libfreehand::FHCollector *collector)
 {
   std::vector<FHColorStop> colorStops;
   unsigned short num = readU16(input);
@@ -1477,7 +1471,7 @@ void libfreehand::FHParser::readMultiColorList(librevenge::RVNGInputStream *inpu
     collector->collectMultiColorList(m_currentRecord+1, colorStops);
 }
 
-void libfreehand::FHParser::readNewBlend(librevenge::RVNGInputStream *input, libfreehand::FHCollector *collector)
+void libfreehand::FHParser::readNewBlend(FHInternalStream *input, libfreehand::FHCollector *collector)
 {
   FHNewBlend newBlend;
   newBlend.m_graphicStyleId = _readRecordId(input);
@@ -1491,7 +1485,7 @@ void libfreehand::FHParser::readNewBlend(librevenge::RVNGInputStream *input, lib
     collector->collectNewBlend(m_currentRecord+1, newBlend);
 }
 
-void libfreehand::FHParser::readNewContourFill(librevenge::RVNGInputStream *input, libfreehand::FHCollector *collector)
+void libfreehand::FHParser::readNewContourFill(FHInternalStream *input, libfreehand::FHCollector *collector)
 {
   FHRadialFill fill;
   fill.m_color1Id = _readRecordId(input);
@@ -1508,7 +1502,7 @@ void libfreehand::FHParser::readNewContourFill(librevenge::RVNGInputStream *inpu
     collector->collectRadialFill(m_currentRecord+1, fill);
 }
 
-void libfreehand::FHParser::readNewRadialFill(librevenge::RVNGInputStream *input, libfreehand::FHCollector *collector)
+void libfreehand::FHParser::readNewRadialFill(FHInternalStream *input, libfreehand::FHCollector *collector)
 {
   FHRadialFill fill;
   fill.m_color1Id = _readRecordId(input);
@@ -1522,7 +1516,7 @@ void libfreehand::FHParser::readNewRadialFill(librevenge::RVNGInputStream *input
     collector->collectRadialFill(m_currentRecord+1, fill);
 }
 
-void libfreehand::FHParser::readOpacityFilter(librevenge::RVNGInputStream *input, libfreehand::FHCollector *collector)
+void libfreehand::FHParser::readOpacityFilter(FHInternalStream *input, libfreehand::FHCollector *collector)
 {
   _readRecordId(input);
   double opacity = (double)(readU16(input)) / 100.0;
@@ -1530,7 +1524,7 @@ void libfreehand::FHParser::readOpacityFilter(librevenge::RVNGInputStream *input
     collector->collectOpacityFilter(m_currentRecord+1, opacity);
 }
 
-void libfreehand::FHParser::readOval(librevenge::RVNGInputStream *input, libfreehand::FHCollector *collector)
+void libfreehand::FHParser::readOval(FHInternalStream *input, libfreehand::FHCollector *collector)
 {
   unsigned short graphicStyle = _readRecordId(input);
   _readRecordId(input); // Layer
@@ -1538,10 +1532,12 @@ void libfreehand::FHParser::readOval(librevenge::RVNGInputStream *input, libfree
     input->seek(4, librevenge::RVNG_SEEK_CUR);
   input->seek(8, librevenge::RVNG_SEEK_CUR);
   unsigned short xform = _readRecordId(input);
-  double xa = _readCoordinate(input) / 72.0;
-  double ya = _readCoordinate(input) / 72.0;
-  double xb = _readCoordinate(input) / 72.0;
-  double yb = _readCoordinate(input) / 72.0;
+  double bbox[4];
+  _readCoordinates(input, bbox, 4);
+  double xa = bbox[0] / 72.0;
+  double ya = bbox[1] / 72.0;
+  double xb = bbox[2] / 72.0;
+  double yb = bbox[3] / 72.0;
   double arc1 = 0.0;
   double arc2 = 0.0;
   bool closed = false;
@@ -1552,6 +1548,8 @@ void libfreehand::FHParser::readOval(librevenge::RVNGInputStream *input, libfree
     closed = bool(readU8(input));
     input->seek(1, librevenge::RVNG_SEEK_CUR);
   }
+  if (!collector)
+    return;
 
   double cx = (xb + xa) / 2.0;
   double cy = (yb + ya) / 2.0;
@@ -1607,11 +1605,11 @@ void libfreehand::FHParser::readOval(librevenge::RVNGInputStream *input, libfree
   path.setXFormId(xform);
   path.setGraphicStyleId(graphicStyle);
   path.setEvenOdd(true);
-  if (collector && !path.empty())
+  if (!path.empty())
     collector->collectPath(m_currentRecord+1, path);
 }
 
-void libfreehand::FHParser::readPantoneColor(librevenge::RVNGInputStream *input, libfreehand::FHCollector *collector)
+void libfreehand::FHParser::readPantoneColor(FHInternalStream *input, libfreehand::FHCollector *collector)
 {
   _readRecordId(input);
   input->seek(2, librevenge::RVNG_SEEK_CUR);
@@ -1621,7 +1619,7 @@ void libfreehand::FHParser::readPantoneColor(librevenge::RVNGInputStream *input,
     collector->collectColor(m_currentRecord+1, color);
 }
 
-void libfreehand::FHParser::readParagraph(librevenge::RVNGInputStream *input, libfreehand::FHCollector *collector)
+void libfreehand::FHParser::readParagraph(FHInternalStream *input, libfreehand::FHCollector *collector)
 {
   input->seek(2, librevenge::RVNG_SEEK_CUR);
   unsigned short size = readU16(input);
@@ -1644,7 +1642,7 @@ void libfreehand::FHParser::readParagraph(librevenge::RVNGInputStream *input, li
     collector->collectParagraph(m_currentRecord+1, paragraph);
 }
 
-void libfreehand::FHParser::readPath(librevenge::RVNGInputStream *input, libfreehand::FHCollector *collector)
+void libfreehand::FHParser::readPath(FHInternalStream *input, libfreehand::FHCollector *collector)
 {
   unsigned short size = readU16(input); // 0-2
   unsigned graphicStyle = _readRecordId(input);
@@ -1659,65 +1657,39 @@ void libfreehand::FHParser::readPath(librevenge::RVNGInputStream *input, libfree
   if (m_version > 8)
     size = numPoints;
 
-  std::vector<unsigned char> ptrTypes;
-  std::vector<std::vector<std::pair<double, double> > > path;
-
-  try
-  {
-    for (unsigned short i = 0; i < numPoints  && !input->isEnd(); ++i)
-    {
-      input->seek(1, librevenge::RVNG_SEEK_CUR);
-      ptrTypes.push_back(readU8(input));
-      input->seek(1, librevenge::RVNG_SEEK_CUR);
-      std::vector<std::pair<double, double> > segment;
-      for (unsigned short j = 0; j < 3 && !input->isEnd(); ++j)
-      {
-        double x = _readCoordinate(input);
-        double y = _readCoordinate(input);
-        std::pair<double, double> tmpPoint = std::make_pair(x, y);
-        segment.push_back(tmpPoint);
-      }
-      if (segment.size() == 3)
-        path.push_back(segment);
-      segment.clear();
-    }
-    input->seek((size-numPoints)*27, librevenge::RVNG_SEEK_CUR);
-  }
-  catch (const EndOfStreamException &)
+  if (!collector)
   {
-    FH_DEBUG_MSG(("Caught EndOfStreamException, continuing\n"));
+    input->seek(size*FH_PATH_NODE_SIZE, librevenge::RVNG_SEEK_CUR);
+    return;
   }
 
-  if (path.empty())
+  std::vector<double> xs;
+  std::vector<double> ys;
+  if (_readPathNodes(input, numPoints, xs, ys) == numPoints)
+    input->seek((size-numPoints)*FH_PATH_NODE_SIZE, librevenge::RVNG_SEEK_CUR);
+
+  if (xs.empty())
   {
     FH_DEBUG_MSG(("No path was read\n"));
     return;
   }
 
-  FHPath fhPath;
-  fhPath.appendMoveTo(path[0][0].first / 72.0, path[0][0].second / 72.0);
-
-  size_t i = 0;
-  for (i = 0; i<path.size()-1; ++i)
-    fhPath.appendCubicBezierTo(path[i][2].first / 72.0, path[i][2].second / 72.0,
-                               path[i+1][1].first / 72.0, path[i+1][1].second / 72.0,
-                               path[i+1][0].first / 72.0,  path[i+1][0].second / 72.0);
-  if (closed)
-  {
-    fhPath.appendCubicBezierTo(path[i][2].first / 72.0, path[i][2].second / 72.0,
-                               path[0][1].first / 72.0, path[0][1].second / 72.0,
-                               path[0][0].first / 72.0, path[0][0].second / 72.0);
+  // points are in 1/72 inch
+  for (double &x : xs)
+    x /= 72.0;
+  for (double &y : ys)
+    y /= 72.0;
 
-    fhPath.appendClosePath();
-  }
+  FHPath fhPath;
+  _appendPathNodes(fhPath, xs, ys, closed);
 
   fhPath.setGraphicStyleId(graphicStyle);
   fhPath.setEvenOdd(evenOdd);
-  if (collector && !fhPath.empty())
+  if (!fhPath.empty())
     collector->collectPath(m_currentRecord+1, fhPath);
 }
 
-void libfreehand::FHParser::readPathText(librevenge::RVNGInputStream *input, libfreehand::FHCollector *collector)
+void libfreehand::FHParser::readPathText(FHInternalStream *input, libfreehand::FHCollector *collector)
 {
   FHPathText group;
   group.m_elementsId=_readRecordId(input);
@@ -1732,13 +1704,7 @@ void libfreehand::FHParser::readPathText(librevenge::RVNGInputStream *input, lib
     collector->collectPathText(m_currentRecord+1, group);
 }
 
-void libfreehand::FHParser::readPathTextLineInfo(librevenge::RVNGInputStream *input, libfreehand::FHCollector * /* collector */)
-{
-  // osnola: only try for N0=5, N1=2, N2=5
-  input->seek(46, librevenge::RVNG_SEEK_CUR);
-}
-
-void libfreehand::FHParser::readPatternFill(librevenge::RVNGInputStream *input, libfreehand::FHCollector *collector)
+void libfreehand::FHParser::readPatternFill(FHInternalStream *input, libfreehand::FHCollector *collector)
 {
   FHPatternFill fill;
   fill.m_colorId = _readRecordId(input);
@@ -1748,7 +1714,7 @@ void libfreehand::FHParser::readPatternFill(librevenge::RVNGInputStream *input,
     collector->collectPatternFill(m_currentRecord+1, fill);
 }
 
-void libfreehand::FHParser::readPatternLine(librevenge::RVNGInputStream *input, libfreehand::FHCollector *collector)
+void libfreehand::FHParser::readPatternLine(FHInternalStream *input, libfreehand::FHCollector *collector)
 {
   FHPatternLine line;
   line.m_colorId = _readRecordId(input);
@@ -1770,12 +1736,7 @@ void libfreehand::FHParser::readPatternLine(librevenge::RVNGInputStream *input,
     collector->collectPatternLine(m_currentRecord+1, line);
 }
 
-void libfreehand::FHParser::readPerspectiveEnvelope(librevenge::RVNGInputStream *input, libfreehand::FHCollector * /* collector */)
-{
-  input->seek(177, librevenge::RVNG_SEEK_CUR);
-}
-
-void libfreehand::FHParser::readPerspectiveGrid(librevenge::RVNGInputStream *input, libfreehand::FHCollector * /* collector */)
+void libfreehand::FHParser::readPerspectiveGrid(FHInternalStream *input, libfreehand::FHCollector * /* collector */)
 {
   while (readU8(input))
   {
@@ -1783,7 +1744,7 @@ void libfreehand::FHParser::readPerspectiveGrid(librevenge::RVNGInputStream *inp
   input->seek(58, librevenge::RVNG_SEEK_CUR);
 }
 
-void libfreehand::FHParser::readPolygonFigure(librevenge::RVNGInputStream *input, libfreehand::FHCollector *collector)
+void libfreehand::FHParser::readPolygonFigure(FHInternalStream *input, libfreehand::FHCollector *collector)
 {
   unsigned short graphicStyle = _readRecordId(input);
   _readRecordId(input); // Layer
@@ -1798,6 +1759,11 @@ void libfreehand::FHParser::readPolygonFigure(librevenge::RVNGInputStream *input
   double r2 = _readCoordinate(input) / 72.0;
   double arc1 = _readCoordinate(input) * M_PI / 180.0;
   double arc2 = _readCoordinate(input) * M_PI / 180.0;
+  if (!collector)
+  {
+    input->seek(8, librevenge::RVNG_SEEK_CUR);
+    return;
+  }
   while (arc1 < 0.0)
     arc1 += 2.0 * M_PI;
   while (arc1 > 2.0 * M_PI)
@@ -1830,30 +1796,30 @@ void libfreehand::FHParser::readPolygonFigure(librevenge::RVNGInputStream *input
   path.setXFormId(xform);
   path.setGraphicStyleId(graphicStyle);
   path.setEvenOdd(evenodd);
-  if (collector && !path.empty())
+  if (!path.empty())
     collector->collectPath(m_currentRecord+1, path);
 }
 
-void libfreehand::FHParser::readProcedure(librevenge::RVNGInputStream *input, libfreehand::FHCollector * /* collector */)
-{
-  input->seek(4, librevenge::RVNG_SEEK_CUR);
-}
-
-void libfreehand::FHParser::readProcessColor(librevenge::RVNGInputStream *input, libfreehand::FHCollector *collector)
+void libfreehand::FHParser::readProcessColor(FHInternalStream *input, libfreehand::FHCollector *collector)
 {
   _readRecordId(input);
   input->seek(2, librevenge::RVNG_SEEK_CUR);
   FHRGBColor color = _readRGBColor(input);
   input->seek(4, librevenge::RVNG_SEEK_CUR);
   if (color.black())
-    color = _readCMYKColor(input);
-  else
-    input->seek(8, librevenge::RVNG_SEEK_CUR);
+  {
+    // converted together with all the others at the end of the document
+    uint64_t cmyk = _readCMYKColor(input);
+    if (collector)
+      m_cmykColors.push_back(std::make_pair(unsigned(m_currentRecord+1), cmyk));
+    return;
+  }
+  input->seek(8, librevenge::RVNG_SEEK_CUR);
   if (collector)
     collector->collectColor(m_currentRecord+1, color);
 }
 
-void libfreehand::FHParser::readPropLst(librevenge::RVNGInputStream *input, libfreehand::FHCollector *collector)
+void libfreehand::FHParser::readPropLst(FHInternalStream *input, libfreehand::FHCollector *collector)
 {
   unsigned short size2 = readU16(input);
   unsigned short size = readU16(input);
@@ -1868,7 +1834,7 @@ void libfreehand::FHParser::readPropLst(librevenge::RVNGInputStream *input, libf
     collector->collectPropList(m_currentRecord+1, propertyList);
 }
 
-void libfreehand::FHParser::readPSFill(librevenge::RVNGInputStream *input, libfreehand::FHCollector *collector)
+void libfreehand::FHParser::readPSFill(FHInternalStream *input, libfreehand::FHCollector *collector)
 {
   FHBasicFill fill;
   fill.m_colorId = _readRecordId(input);
@@ -1877,7 +1843,7 @@ void libfreehand::FHParser::readPSFill(librevenge::RVNGInputStream *input, libfr
     collector->collectBasicFill(m_currentRecord+1, fill);
 }
 
-void libfreehand::FHParser::readPSLine(librevenge::RVNGInputStream *input, libfreehand::FHCollector *collector)
+void libfreehand::FHParser::readPSLine(FHInternalStream *input, libfreehand::FHCollector *collector)
 {
   FHBasicLine line;
   line.m_colorId = _readRecordId(input);
@@ -1887,7 +1853,7 @@ void libfreehand::FHParser::readPSLine(librevenge::RVNGInputStream *input, libfr
     collector->collectBasicLine(m_currentRecord+1, line);
 }
 
-void libfreehand::FHParser::readRadialFill(librevenge::RVNGInputStream *input, libfreehand::FHCollector *collector)
+void libfreehand::FHParser::readRadialFill(FHInternalStream *input, libfreehand::FHCollector *collector)
 {
   FHRadialFill fill;
   fill.m_color1Id = _readRecordId(input);
@@ -1907,7 +1873,7 @@ void libfreehand::FHParser::readRadialFill(librevenge::RVNGInputStream *input, l
     collector->collectRadialFill(m_currentRecord+1, fill);
 }
 
-void libfreehand::FHParser::readRadialFillX(librevenge::RVNGInputStream *input, libfreehand::FHCollector *collector)
+void libfreehand::FHParser::readRadialFillX(FHInternalStream *input, libfreehand::FHCollector *collector)
 {
   FHRadialFill fill;
   fill.m_color1Id = _readRecordId(input);
@@ -1920,12 +1886,7 @@ void libfreehand::FHParser::readRadialFillX(librevenge::RVNGInputStream *input,
     collector->collectRadialFill(m_currentRecord+1, fill);
 }
 
-void libfreehand::FHParser::readRaggedFilter(librevenge::RVNGInputStream *input, libfreehand::FHCollector * /* collector */)
-{
-  input->seek(16, librevenge::RVNG_SEEK_CUR);
-}
-
-void libfreehand::FHParser::readRectangle(librevenge::RVNGInputStream *input, libfreehand::FHCollector *collector)
+void libfreehand::FHParser::readRectangle(FHInternalStream *input, libfreehand::FHCollector *collector)
 {
   unsigned graphicStyle = _readRecordId(input);
   _readRecordId(input);
@@ -1933,12 +1894,14 @@ void libfreehand::FHParser::readRectangle(librevenge::RVNGInputStream *input, li
     input->seek(4, librevenge::RVNG_SEEK_CUR);
   input->seek(8, librevenge::RVNG_SEEK_CUR);
   unsigned xform = _readRecordId(input);
-  double x1 = _readCoordinate(input) / 72.0;
-  double y1 = _readCoordinate(input) / 72.0;
-  double x2 = _readCoordinate(input) / 72.0;
-  double y2 = _readCoordinate(input) / 72.0;
-  double rtlt = _readCoordinate(input) / 72.0;
-  double rtll = _readCoordinate(input) / 72.0;
+  double coords[6];
+  _readCoordinates(input, coords, 6);
+  double x1 = coords[0] / 72.0;
+  double y1 = coords[1] / 72.0;
+  double x2 = coords[2] / 72.0;
+  double y2 = coords[3] / 72.0;
+  double rtlt = coords[4] / 72.0;
+  double rtll = coords[5] / 72.0;
   double rtrt = rtlt;
   double rtrr = rtll;
   double rbrb = rtlt;
@@ -1951,14 +1914,17 @@ void libfreehand::FHParser::readRectangle(librevenge::RVNGInputStream *input, li
   bool rbr(true);
   if (m_version >= 11)
   {
-    rtrt = _readCoordinate(input) / 72.0;
-    rtrr = _readCoordinate(input) / 72.0;
-    rbrb = _readCoordinate(input) / 72.0;
-    rbrr = _readCoordinate(input) / 72.0;
-    rblb = _readCoordinate(input) / 72.0;
-    rbll = _readCoordinate(input) / 72.0;
+    _readCoordinates(input, coords, 6);
+    rtrt = coords[0] / 72.0;
+    rtrr = coords[1] / 72.0;
+    rbrb = coords[2] / 72.0;
+    rbrr = coords[3] / 72.0;
+    rblb = coords[4] / 72.0;
+    rbll = coords[5] / 72.0;
     input->seek(9, librevenge::RVNG_SEEK_CUR);
   }
+  if (!collector)
+    return;
   FHPath path;
 
   if (FH_ALMOST_ZERO(rbll) || FH_ALMOST_ZERO(rblb))
@@ -2010,16 +1976,11 @@ void libfreehand::FHParser::readRectangle(librevenge::RVNGInputStream *input, li
   path.setXFormId(xform);
   path.setGraphicStyleId(graphicStyle);
   path.setEvenOdd(true);
-  if (collector && !path.empty())
+  if (!path.empty())
     collector->collectPath(m_currentRecord+1, path);
 }
 
-void libfreehand::FHParser::readSketchFilter(librevenge::RVNGInputStream *input, libfreehand::FHCollector * /* collector */)
-{
-  input->seek(11, librevenge::RVNG_SEEK_CUR);
-}
-
-void libfreehand::FHParser::readSpotColor(librevenge::RVNGInputStream *input, libfreehand::FHCollector *collector)
+void libfreehand::FHParser::readSpotColor(FHInternalStream *input, libfreehand::FHCollector *collector)
 {
   _readRecordId(input);
   input->seek(2, librevenge::RVNG_SEEK_CUR);
@@ -2029,7 +1990,7 @@ void libfreehand::FHParser::readSpotColor(librevenge::RVNGInputStream *input, li
     collector->collectColor(m_currentRecord+1, color);
 }
 
-void libfreehand::FHParser::readSpotColor6(librevenge::RVNGInputStream *input, libfreehand::FHCollector *collector)
+void libfreehand::FHParser::readSpotColor6(FHInternalStream *input, libfreehand::FHCollector *collector)
 {
   unsigned short size = readU16(input);
   _readRecordId(input);
@@ -2043,7 +2004,7 @@ void libfreehand::FHParser::readSpotColor6(librevenge::RVNGInputStream *input, l
     collector->collectColor(m_currentRecord+1, color);
 }
 
-void libfreehand::FHParser::readStylePropLst(librevenge::RVNGInputStream *input, libfreehand::FHCollector *collector)
+void libfreehand::FHParser::readStylePropLst(FHInternalStream *input, libfreehand::FHCollector *collector)
 {
   if (m_version > 8)
     input->seek(2, librevenge::RVNG_SEEK_CUR);
@@ -2059,7 +2020,7 @@ void libfreehand::FHParser::readStylePropLst(librevenge::RVNGInputStream *input,
     collector->collectPropList(m_currentRecord+1, propertyList);
 }
 
-void libfreehand::FHParser::readSwfImport(librevenge::RVNGInputStream *input, libfreehand::FHCollector *collector)
+void libfreehand::FHParser::readSwfImport(FHInternalStream *input, libfreehand::FHCollector *collector)
 {
   FHImageImport image;
   image.m_graphicStyleId = _readRecordId(input);
@@ -2078,7 +2039,7 @@ void libfreehand::FHParser::readSwfImport(librevenge::RVNGInputStream *input, li
     collector->collectImage(m_currentRecord+1, image);
 }
 
-void libfreehand::FHParser::readSymbolClass(librevenge::RVNGInputStream *input, libfreehand::FHCollector *collector)
+void libfreehand::FHParser::readSymbolClass(FHInternalStream *input, libfreehand::FHCollector *collector)
 {
   FHSymbolClass symbolClass;
   symbolClass.m_nameId = _readRecordId(input);
@@ -2090,7 +2051,7 @@ void libfreehand::FHParser::readSymbolClass(librevenge::RVNGInputStream *input,
     collector->collectSymbolClass(m_currentRecord+1, symbolClass);
 }
 
-void libfreehand::FHParser::readSymbolInstance(librevenge::RVNGInputStream *input, libfreehand::FHCollector *collector)
+void libfreehand::FHParser::readSymbolInstance(FHInternalStream *input, libfreehand::FHCollector *collector)
 {
   FHSymbolInstance symbolInstance;
   symbolInstance.m_graphicStyleId = _readRecordId(input);
@@ -2118,7 +2079,7 @@ void libfreehand::FHParser::readSymbolInstance(librevenge::RVNGInputStream *inpu
     collector->collectSymbolInstance(m_currentRecord+1, symbolInstance);
 }
 
-void libfreehand::FHParser::readSymbolLibrary(librevenge::RVNGInputStream *input, libfreehand::FHCollector * /* collector */)
+void libfreehand::FHParser::readSymbolLibrary(FHInternalStream *input, libfreehand::FHCollector * /* collector */)
 {
   input->seek(2, librevenge::RVNG_SEEK_CUR);
   unsigned short size = readU16(input);
@@ -2127,7 +2088,7 @@ void libfreehand::FHParser::readSymbolLibrary(librevenge::RVNGInputStream *input
     _readRecordId(input);
 }
 
-void libfreehand::FHParser::readTabTable(librevenge::RVNGInputStream *input, libfreehand::FHCollector *collector)
+void libfreehand::FHParser::readTabTable(FHInternalStream *input, libfreehand::FHCollector *collector)
 {
   unsigned short size = readU16(input);
   unsigned short n = readU16(input);
@@ -2150,7 +2111,7 @@ void libfreehand::FHParser::readTabTable(librevenge::RVNGInputStream *input, lib
   input->seek(endPos, librevenge::RVNG_SEEK_SET);
 }
 
-void libfreehand::FHParser::readTaperedFill(librevenge::RVNGInputStream *input, libfreehand::FHCollector *collector)
+void libfreehand::FHParser::readTaperedFill(FHInternalStream *input, libfreehand::FHCollector *collector)
 {
   FHLinearFill fill;
   fill.m_color1Id = _readRecordId(input);
@@ -2161,7 +2122,7 @@ void libfreehand::FHParser::readTaperedFill(librevenge::RVNGInputStream *input,
     collector->collectLinearFill(m_currentRecord+1, fill);
 }
 
-void libfreehand::FHParser::readTaperedFillX(librevenge::RVNGInputStream *input, libfreehand::FHCollector *collector)
+void libfreehand::FHParser::readTaperedFillX(FHInternalStream *input, libfreehand::FHCollector *collector)
 {
   FHLinearFill fill;
   fill.m_color1Id = _readRecordId(input);
@@ -2173,7 +2134,7 @@ void libfreehand::FHParser::readTaperedFillX(librevenge::RVNGInputStream *input,
     collector->collectLinearFill(m_currentRecord+1, fill);
 }
 
-void libfreehand::FHParser::readTEffect(librevenge::RVNGInputStream *input, libfreehand::FHCollector *collector)
+void libfreehand::FHParser::readTEffect(FHInternalStream *input, libfreehand::FHCollector *collector)
 {
   FHTEffect eff;
   input->seek(4, librevenge::RVNG_SEEK_CUR);
@@ -2208,7 +2169,7 @@ void libfreehand::FHParser::readTEffect(librevenge::RVNGInputStream *input, libf
     collector->collectTEffect(m_currentRecord+1, eff);
 }
 
-void libfreehand::FHParser::readTextBlok(librevenge::RVNGInputStream *input, libfreehand::FHCollector *collector)
+void libfreehand::FHParser::readTextBlok(FHInternalStream *input, libfreehand::FHCollector *collector)
 {
   unsigned short size = readU16(input);
   unsigned short length = readU16(input);
@@ -2228,7 +2189,7 @@ void libfreehand::FHParser::readTextBlok(librevenge::RVNGInputStream *input, lib
 #endif
 }
 
-void libfreehand::FHParser::readTextEffs(librevenge::RVNGInputStream *input, libfreehand::FHCollector *collector)
+void libfreehand::FHParser::readTextEffs(FHInternalStream *input, libfreehand::FHCollector *collector)
 {
   unsigned num = readU16(input);
   FHTEffect eff;
@@ -2258,7 +2219,7 @@ void libfreehand::FHParser::readTextEffs(librevenge::RVNGInputStream *input, lib
     collector->collectTEffect(m_currentRecord+1, eff);
 }
 
-void libfreehand::FHParser::readTextObject(librevenge::RVNGInputStream *input, libfreehand::FHCollector *collector)
+void libfreehand::FHParser::readTextObject(FHInternalStream *input, libfreehand::FHCollector *collector)
 {
   input->seek(4, librevenge::RVNG_SEEK_CUR);
   unsigned short num = readU16(input);
@@ -2323,7 +2284,7 @@ void libfreehand::FHParser::readTextObject(librevenge::RVNGInputStream *input, l
     collector->collectTextObject(m_currentRecord+1, textObject);
 }
 
-void libfreehand::FHParser::readTileFill(librevenge::RVNGInputStream *input, libfreehand::FHCollector *collector)
+void libfreehand::FHParser::readTileFill(FHInternalStream *input, libfreehand::FHCollector *collector)
 {
   FHTileFill fill;
   fill.m_xFormId = _readRecordId(input);
@@ -2338,7 +2299,7 @@ void libfreehand::FHParser::readTileFill(librevenge::RVNGInputStream *input, lib
     collector->collectTileFill(m_currentRecord+1, fill);
 }
 
-void libfreehand::FHParser::readTintColor(librevenge::RVNGInputStream *input, libfreehand::FHCollector *collector)
+void libfreehand::FHParser::readTintColor(FHInternalStream *input, libfreehand::FHCollector *collector)
 {
   _readRecordId(input);
   input->seek(2, librevenge::RVNG_SEEK_CUR);
@@ -2362,7 +2323,7 @@ void libfreehand::FHParser::readTintColor(librevenge::RVNGInputStream *input, li
   }
 }
 
-void libfreehand::FHParser::readTintColor6(librevenge::RVNGInputStream *input, libfreehand::FHCollector *collector)
+void libfreehand::FHParser::readTintColor6(FHInternalStream *input, libfreehand::FHCollector *collector)
 {
   input->seek(2, librevenge::RVNG_SEEK_CUR);
   _readRecordId(input);
@@ -2375,12 +2336,7 @@ void libfreehand::FHParser::readTintColor6(librevenge::RVNGInputStream *input, l
     collector->collectColor(m_currentRecord+1, color);
 }
 
-void libfreehand::FHParser::readTransformFilter(librevenge::RVNGInputStream *input, libfreehand::FHCollector * /* collector */)
-{
-  input->seek(39, librevenge::RVNG_SEEK_CUR);
-}
-
-void libfreehand::FHParser::readTString(librevenge::RVNGInputStream *input, libfreehand::FHCollector *collector)
+void libfreehand::FHParser::readTString(FHInternalStream *input, libfreehand::FHCollector *collector)
 {
   unsigned short size2 = readU16(input);
   unsigned short size = readU16(input);
@@ -2397,7 +2353,7 @@ void libfreehand::FHParser::readTString(librevenge::RVNGInputStream *input, libf
     collector->collectTString(m_currentRecord+1, elements);
 }
 
-void libfreehand::FHParser::readUString(librevenge::RVNGInputStream *input, libfreehand::FHCollector *collector)
+void libfreehand::FHParser::readUString(FHInternalStream *input, libfreehand::FHCollector *collector)
 {
   long startPosition = input->tell();
   unsigned short size = readU16(input);
@@ -2424,7 +2380,7 @@ void libfreehand::FHParser::readUString(librevenge::RVNGInputStream *input, libf
     collector->collectString(m_currentRecord+1, str);
 }
 
-void libfreehand::FHParser::readVDict(librevenge::RVNGInputStream *input, libfreehand::FHCollector * /* collector */)
+void libfreehand::FHParser::readVDict(FHInternalStream *input, libfreehand::FHCollector * /* collector */)
 {
   input->seek(4, librevenge::RVNG_SEEK_CUR);
   unsigned short num = readU16(input);
@@ -2440,7 +2396,7 @@ void libfreehand::FHParser::readVDict(librevenge::RVNGInputStream *input, libfre
   }
 }
 
-void libfreehand::FHParser::readVMpObj(librevenge::RVNGInputStream *input, libfreehand::FHCollector *collector)
+void libfreehand::FHParser::readVMpObj(FHInternalStream *input, libfreehand::FHCollector *collector)
 {
   input->seek(4, librevenge::RVNG_SEEK_CUR);
   unsigned short num = readU16(input);
@@ -2449,6 +2405,7 @@ void libfreehand::FHParser::readVMpObj(librevenge::RVNGInputStream *input, libfr
   double minY = 0.0;
   double maxX = 0.0;
   double maxY = 0.0;
+  bool pageSize = false;
   FHParagraphProperties paraProps;
   std::unique_ptr<libfreehand::FHCharProperties> charProps;
   for (unsigned short i = 0; i < num; ++i)
@@ -2481,12 +2438,14 @@ void libfreehand::FHParser::readVMpObj(librevenge::RVNGInputStream *input, libfr
     {
       maxX = minX + _readCoordinate(input) / 72.0;
       m_pageInfo.m_maxX = std::max(maxX,m_pageInfo.m_maxX);
+      pageSize = true;
       break;
     }
     case FH_PAGE_HEIGHT:
     {
       maxY = minY + _readCoordinate(input) / 72.0;
       m_pageInfo.m_maxY = std::max(maxY,m_pageInfo.m_maxY);
+      pageSize = true;
       break;
     }
     case FH_PARA_LEFT_INDENT:
@@ -2555,6 +2514,8 @@ void libfreehand::FHParser::readVMpObj(librevenge::RVNGInputStream *input, libfr
         input->seek(4, librevenge::RVNG_SEEK_CUR);
     }
   }
+  if (pageSize && maxX > minX && maxY > minY)
+    _addPage(minX, minY, maxX, maxY);
   if (collector)
   {
     if (charProps)
@@ -2564,7 +2525,7 @@ void libfreehand::FHParser::readVMpObj(librevenge::RVNGInputStream *input, libfr
   }
 }
 
-void libfreehand::FHParser::readXform(librevenge::RVNGInputStream *input, libfreehand::FHCollector *collector)
+void libfreehand::FHParser::readXform(FHInternalStream *input, libfreehand::FHCollector *collector)
 {
   double m11 = 1.0;
   double m21 = 0.0;
@@ -2610,7 +2571,38 @@ void libfreehand::FHParser::readXform(librevenge::RVNGInputStream *input, libfre
     collector->collectXform(m_currentRecord+1, m11, m21, m12, m22, m13, m23);
 }
 
-unsigned libfreehand::FHParser::_readRecordId(librevenge::RVNGInputStream *input)
+void libfreehand::FHParser::_parseRecord(FHInternalStream *input, libfreehand::FHCollector *collector)
+{
+  const unsigned short id = m_records[m_currentRecord];
+  if (id < m_recordLayouts.size() && m_recordLayouts[id])
+  {
+    FH_DEBUG_MSG(("Skipping record number 0x%x: %s Offset 0x%lx\n", (unsigned)m_currentRecord+1, getTokenName(m_dictionary[id]), input->tell()));
+    _skipRecord(input, *m_recordLayouts[id]);
+  }
+  else if (id < m_recordHandlers.size() && m_recordHandlers[id])
+  {
+    FH_DEBUG_MSG(("Parsing record number 0x%x: %s Offset 0x%lx\n", (unsigned)m_currentRecord+1, getTokenName(m_dictionary[id]), input->tell()));
+    // records that are not asked for are read only to get past them
+    (this->*m_recordHandlers[id])(input, m_recordCollected[id] ? collector : nullptr);
+  }
+  else if (id < m_dictionary.size() && m_dictionary[id] != FH_TOKEN_INVALID)
+  {
+    FH_DEBUG_MSG(("FHParser::parseRecords UNKNOWN TOKEN\n"));
+  }
+  else
+  {
+    FH_DEBUG_MSG(("FHParser::parseRecords NO SUCH TOKEN IN DICTIONARY\n"));
+  }
+}
+
+void libfreehand::FHParser::_parseRecordAt(FHInternalStream *input, libfreehand::FHCollector *collector, const RecordOffset &record)
+{
+  input->seek(record.m_offset, librevenge::RVNG_SEEK_SET);
+  m_currentRecord = record.m_id - 1;
+  _parseRecord(input, collector);
+}
+
+unsigned libfreehand::FHParser::_readRecordId(FHInternalStream *input)
 {
   unsigned recid = readU16(input);
   if (recid == 0xffff)
@@ -2638,12 +2630,57 @@ unsigned libfreehand::FHParser::_xformCalc(unsigned char var1, unsigned char var
   return length;
 }
 
-double libfreehand::FHParser::_readCoordinate(librevenge::RVNGInputStream *input)
+double libfreehand::FHParser::_readCoordinate(FHInternalStream *input)
 {
   return (double)readS32(input)/65536.;
 }
 
-libfreehand::FHRGBColor libfreehand::FHParser::_readRGBColor(librevenge::RVNGInputStream *input)
+void libfreehand::FHParser::_readCoordinates(FHInternalStream *input, double *coords, unsigned count)
+{
+  const unsigned char *p = input->fetch(4*count);
+  for (unsigned i = 0; i < count; ++i, p += 4)
+    coords[i] = decodeCoordinate(p);
+}
+
+unsigned libfreehand::FHParser::_readPathNodes(FHInternalStream *input, unsigned numNodes, std::vector<double> &xs, std::vector<double> &ys)
+{
+  xs.reserve(3*numNodes);
+  ys.reserve(3*numNodes);
+  unsigned i = 0;
+  try
+  {
+    for (; i < numNodes; ++i)
+    {
+      const unsigned char *p = input->fetch(FH_PATH_NODE_SIZE) + 3;
+      for (unsigned j = 0; j < 3; ++j, p += 8)
+      {
+        xs.push_back(decodeCoordinate(p));
+        ys.push_back(decodeCoordinate(p + 4));
+      }
+    }
+  }
+  catch (const EndOfStreamException &)
+  {
+    FH_DEBUG_MSG(("Caught EndOfStreamException, continuing\n"));
+  }
+  return i;
+}
+
+void libfreehand::FHParser::_appendPathNodes(FHPath &path, const std::vector<double> &xs, const std::vector<double> &ys, bool closed)
+{
+  // every node is followed by the control points before and after it
+  const size_t last = xs.size() - 3;
+  path.appendMoveTo(xs[0], ys[0]);
+  for (size_t i = 0; i < last; i += 3)
+    path.appendCubicBezierTo(xs[i+2], ys[i+2], xs[i+4], ys[i+4], xs[i+3], ys[i+3]);
+  if (closed)
+  {
+    path.appendCubicBezierTo(xs[last+2], ys[last+2], xs[1], ys[1], xs[0], ys[0]);
+    path.appendClosePath();
+  }
+}
+
+libfreehand::FHRGBColor libfreehand::FHParser::_readRGBColor(FHInternalStream *input)
 {
   FHRGBColor tmpColor;
   tmpColor.m_red = readU16(input);
@@ -2652,7 +2689,7 @@ libfreehand::FHRGBColor libfreehand::FHParser::_readRGBColor(librevenge::RVNGInp
   return tmpColor;
 }
 
-libfreehand::FHRGBColor libfreehand::FHParser::_readCMYKColor(librevenge::RVNGInputStream *input)
+uint64_t libfreehand::FHParser::_readCMYKColor(FHInternalStream *input)
 {
   unsigned short cmyk[4] = { 0, 0, 0, 0 };
 
@@ -2661,18 +2698,83 @@ libfreehand::FHRGBColor libfreehand::FHParser::_readCMYKColor(librevenge::RVNGIn
   cmyk[1] = readU16(input); // M
   cmyk[2] = readU16(input); // Y
 
-  unsigned short rgb[3] = { 0, 0, 0 };
+  return packCMYK(cmyk);
+}
 
-  cmsDoTransform(m_colorTransform, cmyk, rgb, 1);
+void libfreehand::FHParser::_convertCMYKColors(FHCollector *collector)
+{
+  if (m_cmykColors.empty())
+    return;
 
-  FHRGBColor tmpColor;
-  tmpColor.m_red = rgb[0];
-  tmpColor.m_green = rgb[1];
-  tmpColor.m_blue = rgb[2];
-  return tmpColor;
+  std::map<uint64_t, FHRGBColor> colors;
+  std::vector<uint64_t> keys;
+  const bool exact = m_options.m_colorConversion == FH_COLOR_CONVERSION_EXACT || getCMYKLookupTable().empty();
+  {
+    // the lookup table results are not cached, so the fast mode does not
+    // touch the shared cache at all
+    std::unique_lock<std::mutex> lock(getCMYKCacheMutex(), std::defer_lock);
+    const std::map<uint64_t, FHRGBColor> *cache = nullptr;
+    if (exact)
+    {
+      lock.lock();
+      cache = &getCMYKCache();
+    }
+    for (std::vector<std::pair<unsigned, uint64_t> >::const_iterator iter = m_cmykColors.begin(); iter != m_cmykColors.end(); ++iter)
+    {
+      if (colors.find(iter->second) != colors.end())
+        continue;
+      if (cache)
+      {
+        std::map<uint64_t, FHRGBColor>::const_iterator cached = cache->find(iter->second);
+        if (cached != cache->end())
+        {
+          colors[iter->second] = cached->second;
+          continue;
+        }
+      }
+      colors[iter->second] = FHRGBColor();
+      keys.push_back(iter->second);
+    }
+  }
+
+  cmsHTRANSFORM transform = keys.empty() ? nullptr : getCMYKTransform();
+  if (transform)
+  {
+    std::vector<unsigned short> cmyk(4 * keys.size());
+    std::vector<unsigned short> rgb(3 * keys.size());
+    for (std::vector<uint64_t>::size_type i = 0; i < keys.size(); ++i)
+      unpackCMYK(keys[i], &cmyk[4 * i]);
+
+    if (exact)
+      cmsDoTransform(transform, &cmyk[0], &rgb[0], keys.size());
+    else
+      getCMYKLookupTable().convert(&cmyk[0], &rgb[0], keys.size());
+
+    std::unique_lock<std::mutex> lock(getCMYKCacheMutex(), std::defer_lock);
+    std::map<uint64_t, FHRGBColor> *cache = nullptr;
+    if (exact)
+    {
+      lock.lock();
+      cache = &getCMYKCache();
+    }
+    for (std::vector<uint64_t>::size_type i = 0; i < keys.size(); ++i)
+    {
+      FHRGBColor &color = colors[keys[i]];
+      color.m_red = rgb[3 * i];
+      color.m_green = rgb[3 * i + 1];
+      color.m_blue = rgb[3 * i + 2];
+      // only lcms results are kept
+      if (cache && cache->size() < FH_CMYK_CACHE_MAX_SIZE)
+        (*cache)[keys[i]] = color;
+    }
+  }
+
+  for (std::vector<std::pair<unsigned, uint64_t> >::const_iterator iter = m_cmykColors.begin(); iter != m_cmykColors.end(); ++iter)
+    collector->collectColor(iter->first, colors[iter->second]);
+  m_cmykColors.clear();
 }
 
-void libfreehand::FHParser::_readBlockInformation(librevenge::RVNGInputStream *input, unsigned i, unsigned &layerListId)
+void libfreehand::FHParser::_readBlockInformation(FHInternalStream *input, unsigned i, unsigned &layerListId)
 {
   if (i == 5)
     layerListId = _readRecordId(input);
@@ -2680,7 +2782,7 @@ void libfreehand::FHParser::_readBlockInformation(librevenge::RVNGInputStream *i
     _readRecordId(input);
 }
 
-void libfreehand::FHParser::_readPropLstElements(librevenge::RVNGInputStream *input, std::map<unsigned, unsigned> &properties, unsigned size)
+void libfreehand::FHParser::_readPropLstElements(FHInternalStream *input, std::map<unsigned, unsigned> &properties, unsigned size)
 {
   for (unsigned i = 0; i < size; ++i)
   {
@@ -2691,7 +2793,7 @@ void libfreehand::FHParser::_readPropLstElements(librevenge::RVNGInputStream *in
   }
 }
 
-void libfreehand::FHParser::_readFH3CharProperties(librevenge::RVNGInputStream *input, FH3CharProperties &charProps)
+void libfreehand::FHParser::_readFH3CharProperties(FHInternalStream *input, FH3CharProperties &charProps)
 {
   charProps.m_offset = readU16(input);
   unsigned flags = readU16(input);
@@ -2737,7 +2839,7 @@ void libfreehand::FHParser::_readFH3CharProperties(librevenge::RVNGInputStream *
   }
 }
 
-void libfreehand::FHParser::_readFH3ParaProperties(librevenge::RVNGInputStream *input, FH3ParaProperties &paraProps)
+void libfreehand::FHParser::_readFH3ParaProperties(FHInternalStream *input, FH3ParaProperties &paraProps)
 {
   paraProps.m_offset = readU16(input);
   input->seek(28, librevenge::RVNG_SEEK_CUR);
@@ -11,173 +11,201 @@
 #define __FHPARSER_H__
 
 #include <map>
+#include <memory>
 #include <vector>
-#include <lcms2.h>
+#include <boost/cstdint.hpp>
 #include <librevenge/librevenge.h>
+#include <libfreehand/libfreehand.h>
 #include "FHTypes.h"
 
 namespace libfreehand
 {
 
 class FHCollector;
+class FHInternalStream;
 
 class FHParser
 {
 public:
-  explicit FHParser();
+  explicit FHParser(const FHParseOptions &options = FHParseOptions());
   virtual ~FHParser();
   bool parse(librevenge::RVNGInputStream *input, librevenge::RVNGDrawingInterface *painter);
+  bool getInfo(librevenge::RVNGInputStream *input, FHDocumentInfo &info);
+
+  // Where a record starts in the data of the document
+  struct RecordOffset
+  {
+    RecordOffset(unsigned id, int tokenId, long offset)
+      : m_id(id), m_tokenId(tokenId), m_offset(offset) {}
+    unsigned m_id;
+    int m_tokenId;
+    long m_offset;
+  };
+
+  // The records found by the last parse() or getInfo(), in the order of
+  // the document
+  const std::vector<RecordOffset> &getRecordOffsets() const;
+  // Parses the same input again, seeking to each record through the index
+  // built by the last parse() instead of reading the records in sequence.
+  // Fails if nothing has been parsed yet.
+  bool parseFromIndex(librevenge::RVNGInputStream *input, librevenge::RVNGDrawingInterface *painter);
 private:
+  typedef void (FHParser::*RecordHandler)(FHInternalStream *input, FHCollector *collector);
+
+  // Size of a record that is only skipped
+  struct RecordLayout
+  {
+    int m_tokenId;
+    unsigned m_size;
+    unsigned m_itemSize;
+  };
+
   FHParser(const FHParser &);
   FHParser &operator=(const FHParser &);
 
+  std::unique_ptr<FHInternalStream> _openDocument(librevenge::RVNGInputStream *input);
   void parseDictionary(librevenge::RVNGInputStream *input);
   void parseRecordList(librevenge::RVNGInputStream *input);
-  void parseRecord(librevenge::RVNGInputStream *input, FHCollector *collector, int recordId);
-  void parseRecords(librevenge::RVNGInputStream *input, FHCollector *collector);
-  void parseDocument(librevenge::RVNGInputStream *input, FHCollector *collector);
-
-  void readAGDFont(librevenge::RVNGInputStream *input, FHCollector *collector);
-  void readAGDSelection(librevenge::RVNGInputStream *input, FHCollector *collector);
-  void readArrowPath(librevenge::RVNGInputStream *input, FHCollector *collector);
-  void readAttributeHolder(librevenge::RVNGInputStream *input, FHCollector *collector);
-  void readBasicFill(librevenge::RVNGInputStream *input, FHCollector *collector);
-  void readBasicLine(librevenge::RVNGInputStream *input, FHCollector *collector);
-  void readBendFilter(librevenge::RVNGInputStream *input, FHCollector *collector);
-  void readBlendObject(librevenge::RVNGInputStream *input, FHCollector *collector);
-  void readBlock(librevenge::RVNGInputStream *input, FHCollector *collector);
-  void readBrush(librevenge::RVNGInputStream *input, FHCollector *collector);
-  void readBrushStroke(librevenge::RVNGInputStream *input, FHCollector *collector);
-  void readBrushTip(librevenge::RVNGInputStream *input, FHCollector *collector);
-  void readCalligraphicStroke(librevenge::RVNGInputStream *input, FHCollector *collector);
-  void readCharacterFill(librevenge::RVNGInputStream *input, FHCollector *collector);
-  void readClipGroup(librevenge::RVNGInputStream *input, FHCollector *collector);
-  void readCollector(librevenge::RVNGInputStream *input, FHCollector *collector);
-  void readColor6(librevenge::RVNGInputStream *input, FHCollector *collector);
-  void readCompositePath(librevenge::RVNGInputStream *input, FHCollector *collector);
-  void readConeFill(librevenge::RVNGInputStream *input, FHCollector *collector);
-  void readConnectorLine(librevenge::RVNGInputStream *input, FHCollector *collector);
-  void readContentFill(librevenge::RVNGInputStream *input, FHCollector *collector);
-  void readContourFill(librevenge::RVNGInputStream *input, FHCollector *collector);
-  void readCustomProc(librevenge::RVNGInputStream *input, FHCollector *collector);
-  void readDataList(librevenge::RVNGInputStream *input, FHCollector *collector);
-  void readData(librevenge::RVNGInputStream *input, FHCollector *collector);
-  void readDateTime(librevenge::RVNGInputStream *input, FHCollector *collector);
-  void readDisplayText(librevenge::RVNGInputStream *input, FHCollector *collector);
-  void readDuetFilter(librevenge::RVNGInputStream *input, FHCollector *collector);
-  void readElement(librevenge::RVNGInputStream *input, FHCollector *collector);
-  void readElemList(librevenge::RVNGInputStream *input, FHCollector *collector);
-  void readElemPropLst(librevenge::RVNGInputStream *input, FHCollector *collector);
-  void readEnvelope(librevenge::RVNGInputStream *input, FHCollector *collector);
-  void readExpandFilter(librevenge::RVNGInputStream *input, FHCollector *collector);
-  void readExtrusion(librevenge::RVNGInputStream *input, FHCollector *collector);
-  void readFHDocHeader(librevenge::RVNGInputStream *input, FHCollector *collector);
-  void readFHTail(librevenge::RVNGInputStream *input, FHCollector *collector);
-  void readFigure(librevenge::RVNGInputStream *input, FHCollector *collector);
-  void readFileDescriptor(librevenge::RVNGInputStream *input, FHCollector *collector);
-  void readFilterAttributeHolder(librevenge::RVNGInputStream *input, FHCollector *collector);
-  void readFWBevelFilter(librevenge::RVNGInputStream *input, FHCollector *collector);
-  void readFWBlurFilter(librevenge::RVNGInputStream *input, FHCollector *collector);
-  void readFWFeatherFilter(librevenge::RVNGInputStream *input, FHCollector *collector);
-  void readFWGlowFilter(librevenge::RVNGInputStream *input, FHCollector *collector);
-  void readFWShadowFilter(librevenge::RVNGInputStream *input, FHCollector *collector);
-  void readFWSharpenFilter(librevenge::RVNGInputStream *input, FHCollector *collector);
-  void readGradientMaskFilter(librevenge::RVNGInputStream *input, FHCollector *collector);
-  void readGraphicStyle(librevenge::RVNGInputStream *input, FHCollector *collector);
-  void readGroup(librevenge::RVNGInputStream *input, FHCollector *collector);
-  void readGuides(librevenge::RVNGInputStream *input, FHCollector *collector);
-  void readHalftone(librevenge::RVNGInputStream *input, FHCollector *collector);
-  void readImageFill(librevenge::RVNGInputStream *input, FHCollector *collector);
-  void readImageImport(librevenge::RVNGInputStream *input, FHCollector *collector);
-  void readImport(librevenge::RVNGInputStream *input, FHCollector *collector);
-  void readLayer(librevenge::RVNGInputStream *input, FHCollector *collector);
-  void readLensFill(librevenge::RVNGInputStream *input, FHCollector *collector);
-  void readLinearFill(librevenge::RVNGInputStream *input, FHCollector *collector);
-  void readLinePat(librevenge::RVNGInputStream *input, FHCollector *collector);
-  void readLineTable(librevenge::RVNGInputStream *input, FHCollector *collector);
-  void readList(librevenge::RVNGInputStream *input, FHCollector *collector);
-  void readMasterPageDocMan(librevenge::RVNGInputStream *input, FHCollector *collector);
-  void readMasterPageElement(librevenge::RVNGInputStream *input, FHCollector *collector);
-  void readMasterPageLayerElement(librevenge::RVNGInputStream *input, FHCollector *collector);
-  void readMasterPageLayerInstance(librevenge::RVNGInputStream *input, FHCollector *collector);
-  void readMasterPageSymbolClass(librevenge::RVNGInputStream *input, FHCollector *collector);
-  void readMasterPageSymbolInstance(librevenge::RVNGInputStream *input, FHCollector *collector);
-  void readMDict(librevenge::RVNGInputStream *input, FHCollector *collector);
-  void readMName(librevenge::RVNGInputStream *input, FHCollector *collector);
-  void readMpObject(librevenge::RVNGInputStream *input, FHCollector *collector);
-  void readMQuickDict(librevenge::RVNGInputStream *input, FHCollector *collector);
-  void readMString(librevenge::RVNGInputStream *input, FHCollector *collector);
-  void readMultiBlend(librevenge::RVNGInputStream *input, FHCollector *collector);
-  void readMultiColorList(librevenge::RVNGInputStream *input, FHCollector *collector);
-  void readNewBlend(librevenge::RVNGInputStream *input, FHCollector *collector);
-  void readNewContourFill(librevenge::RVNGInputStream *input, FHCollector *collector);
-  void readNewRadialFill(librevenge::RVNGInputStream *input, FHCollector *collector);
-  void readOpacityFilter(librevenge::RVNGInputStream *input, FHCollector *collector);
-  void readOval(librevenge::RVNGInputStream *input, FHCollector *collector);
-  void readPantoneColor(librevenge::RVNGInputStream *input, FHCollector *collector);
-  void readParagraph(librevenge::RVNGInputStream *input, FHCollector *collector);
-  void readPath(librevenge::RVNGInputStream *input, FHCollector *collector);
-  void readPathText(librevenge::RVNGInputStream *input, FHCollector *collector);
-  void readPathTextLineInfo(librevenge::RVNGInputStream *input, FHCollector *collector);
-  void readPatternFill(librevenge::RVNGInputStream *input, FHCollector *collector);
-  void readPatternLine(librevenge::RVNGInputStream *input, FHCollector *collector);
-  void readPerspectiveEnvelope(librevenge::RVNGInputStream *input, FHCollector *collector);
-  void readPerspectiveGrid(librevenge::RVNGInputStream *input, FHCollector *collector);
-  void readPolygonFigure(librevenge::RVNGInputStream *input, FHCollector *collector);
-  void readProcedure(librevenge::RVNGInputStream *input, FHCollector *collector);
-  void readProcessColor(librevenge::RVNGInputStream *input, FHCollector *collector);
-  void readPropLst(librevenge::RVNGInputStream *input, FHCollector *collector);
-  void readPSFill(librevenge::RVNGInputStream *input, FHCollector *collector);
-  void readPSLine(librevenge::RVNGInputStream *input, FHCollector *collector);
-  void readRadialFill(librevenge::RVNGInputStream *input, FHCollector *collector);
-  void readRadialFillX(librevenge::RVNGInputStream *input, FHCollector *collector);
-  void readRaggedFilter(librevenge::RVNGInputStream *input, FHCollector *collector);
-  void readRectangle(librevenge::RVNGInputStream *input, FHCollector *collector);
-  void readSketchFilter(librevenge::RVNGInputStream *input, FHCollector *collector);
-  void readSpotColor(librevenge::RVNGInputStream *input, FHCollector *collector);
-  void readSpotColor6(librevenge::RVNGInputStream *input, FHCollector *collector);
-  void readStylePropLst(librevenge::RVNGInputStream *input, FHCollector *collector);
-  void readSwfImport(librevenge::RVNGInputStream *input, FHCollector *collector);
-  void readSymbolClass(librevenge::RVNGInputStream *input, FHCollector *collector);
-  void readSymbolInstance(librevenge::RVNGInputStream *input, FHCollector *collector);
-  void readSymbolLibrary(librevenge::RVNGInputStream *input, FHCollector *collector);
-  void readTabTable(librevenge::RVNGInputStream *input, FHCollector *collector);
-  void readTaperedFill(librevenge::RVNGInputStream *input, FHCollector *collector);
-  void readTaperedFillX(librevenge::RVNGInputStream *input, FHCollector *collector);
-  void readTEffect(librevenge::RVNGInputStream *input, FHCollector *collector);
-  void readTextBlok(librevenge::RVNGInputStream *input, FHCollector *collector);
-  void readTextEffs(librevenge::RVNGInputStream *input, FHCollector *collector);
-  void readTextObject(librevenge::RVNGInputStream *input, FHCollector *collector);
-  void readTileFill(librevenge::RVNGInputStream *input, FHCollector *collector);
-  void readTintColor(librevenge::RVNGInputStream *input, FHCollector *collector);
-  void readTintColor6(librevenge::RVNGInputStream *input, FHCollector *collector);
-  void readTransformFilter(librevenge::RVNGInputStream *input, FHCollector *collector);
-  void readTString(librevenge::RVNGInputStream *input, FHCollector *collector);
-  void readUString(librevenge::RVNGInputStream *input, FHCollector *collector);
-  void readVDict(librevenge::RVNGInputStream *input, FHCollector *collector);
-  void readVMpObj(librevenge::RVNGInputStream *input, FHCollector *collector);
-  void readXform(librevenge::RVNGInputStream *input, FHCollector *collector);
-
-  unsigned _readRecordId(librevenge::RVNGInputStream *input);
+  void parseRecords(FHInternalStream *input, FHCollector *collector);
+  void parseDocument(FHInternalStream *input, FHCollector *collector);
+  void _finishDocument(FHCollector *collector);
+
+  void readAGDFont(FHInternalStream *input, FHCollector *collector);
+  void readArrowPath(FHInternalStream *input, FHCollector *collector);
+  void readAttributeHolder(FHInternalStream *input, FHCollector *collector);
+  void readBasicFill(FHInternalStream *input, FHCollector *collector);
+  void readBasicLine(FHInternalStream *input, FHCollector *collector);
+  void readBlendObject(FHInternalStream *input, FHCollector *collector);
+  void readBlock(FHInternalStream *input, FHCollector *collector);
+  void readBrush(FHInternalStream *input, FHCollector *collector);
+  void readBrushStroke(FHInternalStream *input, FHCollector *collector);
+  void readBrushTip(FHInternalStream *input, FHCollector *collector);
+  void readCalligraphicStroke(FHInternalStream *input, FHCollector *collector);
+  void readClipGroup(FHInternalStream *input, FHCollector *collector);
+  void readColor6(FHInternalStream *input, FHCollector *collector);
+  void readCompositePath(FHInternalStream *input, FHCollector *collector);
+  void readConeFill(FHInternalStream *input, FHCollector *collector);
+  void readConnectorLine(FHInternalStream *input, FHCollector *collector);
+  void readContourFill(FHInternalStream *input, FHCollector *collector);
+  void readCustomProc(FHInternalStream *input, FHCollector *collector);
+  void readDataList(FHInternalStream *input, FHCollector *collector);
+  void readData(FHInternalStream *input, FHCollector *collector);
+  void readDisplayText(FHInternalStream *input, FHCollector *collector);
+  void readElemPropLst(FHInternalStream *input, FHCollector *collector);
+  void readEnvelope(FHInternalStream *input, FHCollector *collector);
+  void readExtrusion(FHInternalStream *input, FHCollector *collector);
+  void readFHTail(FHInternalStream *input, FHCollector *collector);
+  void readFileDescriptor(FHInternalStream *input, FHCollector *collector);
+  void readFilterAttributeHolder(FHInternalStream *input, FHCollector *collector);
+  void readFWBevelFilter(FHInternalStream *input, FHCollector *collector);
+  void readFWGlowFilter(FHInternalStream *input, FHCollector *collector);
+  void readFWShadowFilter(FHInternalStream *input, FHCollector *collector);
+  void readGradientMaskFilter(FHInternalStream *input, FHCollector *collector);
+  void readGraphicStyle(FHInternalStream *input, FHCollector *collector);
+  void readGroup(FHInternalStream *input, FHCollector *collector);
+  void readGuides(FHInternalStream *input, FHCollector *collector);
+  void readHalftone(FHInternalStream *input, FHCollector *collector);
+  void readImageImport(FHInternalStream *input, FHCollector *collector);
+  void readLayer(FHInternalStream *input, FHCollector *collector);
+  void readLensFill(FHInternalStream *input, FHCollector *collector);
+  void readLinearFill(FHInternalStream *input, FHCollector *collector);
+  void readLinePat(FHInternalStream *input, FHCollector *collector);
+  void readLineTable(FHInternalStream *input, FHCollector *collector);
+  void readList(FHInternalStream *input, FHCollector *collector);
+  void readMasterPageLayerInstance(FHInternalStream *input, FHCollector *collector);
+  void readMasterPageSymbolInstance(FHInternalStream *input, FHCollector *collector);
+  void readMDict(FHInternalStream *input, FHCollector *collector);
+  void readMName(FHInternalStream *input, FHCollector *collector);
+  void readMString(FHInternalStream *input, FHCollector *collector);
+  void readMultiBlend(FHInternalStream *input, FHCollector *collector);
+  void readMultiColorList(FHInternalStream *input, FHCollector *collector);
+  void readNewBlend(FHInternalStream *input, FHCollector *collector);
+  void readNewContourFill(FHInternalStream *input, FHCollector *collector);
+  void readNewRadialFill(FHInternalStream *input, FHCollector *collector);
+  void readOpacityFilter(FHInternalStream *input, FHCollector *collector);
+  void readOval(FHInternalStream *input, FHCollector *collector);
+  void readPantoneColor(FHInternalStream *input, FHCollector *collector);
+  void readParagraph(FHInternalStream *input, FHCollector *collector);
+  void readPath(FHInternalStream *input, FHCollector *collector);
+  void readPathText(FHInternalStream *input, FHCollector *collector);
+  void readPatternFill(FHInternalStream *input, FHCollector *collector);
+  void readPatternLine(FHInternalStream *input, FHCollector *collector);
+  void readPerspectiveGrid(FHInternalStream *input, FHCollector *collector);
+  void readPolygonFigure(FHInternalStream *input, FHCollector *collector);
+  void readProcessColor(FHInternalStream *input, FHCollector *collector);
+  void readPropLst(FHInternalStream *input, FHCollector *collector);
+  void readPSFill(FHInternalStream *input, FHCollector *collector);
+  void readPSLine(FHInternalStream *input, FHCollector *collector);
+  void readRadialFill(FHInternalStream *input, FHCollector *collector);
+  void readRadialFillX(FHInternalStream *input, FHCollector *collector);
+  void readRectangle(FHInternalStream *input, FHCollector *collector);
+  void readSpotColor(FHInternalStream *input, FHCollector *collector);
+  void readSpotColor6(FHInternalStream *input, FHCollector *collector);
+  void readStylePropLst(FHInternalStream *input, FHCollector *collector);
+  void readSwfImport(FHInternalStream *input, FHCollector *collector);
+  void readSymbolClass(FHInternalStream *input, FHCollector *collector);
+  void readSymbolInstance(FHInternalStream *input, FHCollector *collector);
+  void readSymbolLibrary(FHInternalStream *input, FHCollector *collector);
+  void readTabTable(FHInternalStream *input, FHCollector *collector);
+  void readTaperedFill(FHInternalStream *input, FHCollector *collector);
+  void readTaperedFillX(FHInternalStream *input, FHCollector *collector);
+  void readTEffect(FHInternalStream *input, FHCollector *collector);
+  void readTextBlok(FHInternalStream *input, FHCollector *collector);
+  void readTextEffs(FHInternalStream *input, FHCollector *collector);
+  void readTextObject(FHInternalStream *input, FHCollector *collector);
+  void readTileFill(FHInternalStream *input, FHCollector *collector);
+  void readTintColor(FHInternalStream *input, FHCollector *collector);
+  void readTintColor6(FHInternalStream *input, FHCollector *collector);
+  void readTString(FHInternalStream *input, FHCollector *collector);
+  void readUString(FHInternalStream *input, FHCollector *collector);
+  void readVDict(FHInternalStream *input, FHCollector *collector);
+  void readVMpObj(FHInternalStream *input, FHCollector *collector);
+  void readXform(FHInternalStream *input, FHCollector *collector);
+
+  static RecordHandler _getRecordHandler(int tokenId);
+  static unsigned _getRecordCategory(int tokenId);
+  static const RecordLayout *_getRecordLayout(int tokenId);
+  void _skipRecord(FHInternalStream *input, const RecordLayout &layout);
+  void _parseRecord(FHInternalStream *input, FHCollector *collector);
+  void _parseRecordAt(FHInternalStream *input, FHCollector *collector, const RecordOffset &record);
+
+  unsigned _readRecordId(FHInternalStream *input);
 
   unsigned _xformCalc(unsigned char var1, unsigned char var2);
 
-  double _readCoordinate(librevenge::RVNGInputStream *input);
-  FHRGBColor _readRGBColor(librevenge::RVNGInputStream *input);
-  FHRGBColor _readCMYKColor(librevenge::RVNGInputStream *input);
-  void _readPropLstElements(librevenge::RVNGInputStream *input, std::map<unsigned, unsigned> &properties, unsigned size);
-  void _readBlockInformation(librevenge::RVNGInputStream *input, unsigned i, unsigned &layerListId);
-  void _readFH3CharProperties(librevenge::RVNGInputStream *input, FH3CharProperties &charProps);
-  void _readFH3ParaProperties(librevenge::RVNGInputStream *input, FH3ParaProperties &paraProps);
+  double _readCoordinate(FHInternalStream *input);
+  void _readCoordinates(FHInternalStream *input, double *coords, unsigned count);
+  unsigned _readPathNodes(FHInternalStream *input, unsigned numNodes, std::vector<double> &xs, std::vector<double> &ys);
+  void _appendPathNodes(FHPath &path, const std::vector<double> &xs, const std::vector<double> &ys, bool closed);
+  FHRGBColor _readRGBColor(FHInternalStream *input);
+  uint64_t _readCMYKColor(FHInternalStream *input);
+  void _convertCMYKColors(FHCollector *collector);
+  void _addPage(double minX, double minY, double maxX, double maxY);
+  void _readPropLstElements(FHInternalStream *input, std::map<unsigned, unsigned> &properties, unsigned size);
+  void _readBlockInformation(FHInternalStream *input, unsigned i, unsigned &layerListId);
+  void _readFH3CharProperties(FHInternalStream *input, FH3CharProperties &charProps);
+  void _readFH3ParaProperties(FHInternalStream *input, FH3ParaProperties &paraProps);
 
   librevenge::RVNGInputStream *m_input;
   FHCollector *m_collector;
   int m_version;
-  std::map<unsigned short, int> m_dictionary;
+  // Token ids, record handlers, layouts of skipped records and whether
+  // the records are collected, indexed by dictionary id
+  std::vector<int> m_dictionary;
+  std::vector<RecordHandler> m_recordHandlers;
+  std::vector<const RecordLayout *> m_recordLayouts;
+  std::vector<bool> m_recordCollected;
   std::vector<unsigned short> m_records;
   std::vector<unsigned short>::size_type m_currentRecord;
   FHPageInfo m_pageInfo;
-  cmsHTRANSFORM m_colorTransform;
+  // One for each page found in VMpObj records, in the order of the document
+  std::vector<FHPageInfo> m_pages;
+  FHParseOptions m_options;
+  // Process colors given in CMYK, waiting for conversion: record id, packed CMYK
+  std::vector<std::pair<unsigned, uint64_t> > m_cmykColors;
+  // Filled by parseRecords(); the tail follows the last record
+  std::vector<RecordOffset> m_recordOffsets;
+  long m_tailOffset;
 };
 
 } // namespace libfreehand
@@ -10,9 +10,8 @@
 #ifndef __FHPATH_H__
 #define __FHPATH_H__
 
-#include <memory>
+#include <string>
 #include <vector>
-#include <ostream>
 
 #include <librevenge/librevenge.h>
 
@@ -21,25 +20,10 @@ namespace libfreehand
 
 struct FHTransform;
 
-class FHPathElement
-{
-public:
-  FHPathElement() {}
-  virtual ~FHPathElement() {}
-  virtual void writeOut(librevenge::RVNGPropertyListVector &vec) const = 0;
-  virtual void writeOut(std::ostream &s) const = 0;
-  virtual void transform(const FHTransform &trafo) = 0;
-  virtual FHPathElement *clone() = 0;
-  virtual void getBoundingBox(double x0, double y0, double &px, double &py, double &qx, double &qy) const = 0;
-  virtual double getX() const = 0;
-  virtual double getY() const = 0;
-};
-
-
 class FHPath
 {
 public:
-  FHPath() : m_elements(), m_isClosed(false), m_xFormId(0), m_graphicStyleId(0), m_evenOdd(false) {}
+  FHPath() : m_commands(), m_coords(), m_isClosed(false), m_xFormId(0), m_graphicStyleId(0), m_evenOdd(false) {}
   FHPath(const FHPath &path);
   ~FHPath();
 
@@ -72,7 +56,10 @@ public:
   void getBoundingBox(double &xmin, double &ymin, double &xmax, double &ymax) const;
 
 private:
-  std::vector<std::unique_ptr<FHPathElement>> m_elements;
+  // One command per segment; its coordinates follow each other in m_coords,
+  // always ending with the segment's end point.
+  std::vector<unsigned char> m_commands;
+  std::vector<double> m_coords;
   bool m_isClosed;
   unsigned m_xFormId;
   unsigned m_graphicStyleId;
@@ -0,0 +1,145 @@
+/* -*- Mode: C++; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/*
+ * This file is part of the libfreehand project.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef __FHRECORDSTORE_H__
+#define __FHRECORDSTORE_H__
+
+#include <utility>
+#include <vector>
+
+namespace libfreehand
+{
+
+enum FHRecordType
+{
+  FH_RECORD_NONE = 0,
+  FH_RECORD_TRANSFORM,
+  FH_RECORD_PATH,
+  FH_RECORD_STRING,
+  FH_RECORD_LIST,
+  FH_RECORD_LAYER,
+  FH_RECORD_GROUP,
+  FH_RECORD_CLIP_GROUP,
+  FH_RECORD_COMPOSITE_PATH,
+  FH_RECORD_PATH_TEXT,
+  FH_RECORD_TSTRING,
+  FH_RECORD_AGD_FONT,
+  FH_RECORD_TEFFECT,
+  FH_RECORD_PARAGRAPH,
+  FH_RECORD_TAB_TABLE,
+  FH_RECORD_TEXT_BLOK,
+  FH_RECORD_TEXT_OBJECT,
+  FH_RECORD_CHAR_PROPERTIES,
+  FH_RECORD_RGB_COLOR,
+  FH_RECORD_BASIC_FILL,
+  FH_RECORD_PROPERTY_LIST,
+  FH_RECORD_BASIC_LINE,
+  FH_RECORD_CUSTOM_PROC,
+  FH_RECORD_PATTERN_LINE,
+  FH_RECORD_DISPLAY_TEXT,
+  FH_RECORD_GRAPHIC_STYLE,
+  FH_RECORD_ATTRIBUTE_HOLDER,
+  FH_RECORD_DATA,
+  FH_RECORD_DATA_LIST,
+  FH_RECORD_IMAGE,
+  FH_RECORD_MULTI_COLOR_LIST,
+  FH_RECORD_LINEAR_FILL,
+  FH_RECORD_TINT_COLOR,
+  FH_RECORD_LENS_FILL,
+  FH_RECORD_RADIAL_FILL,
+  FH_RECORD_NEW_BLEND,
+  FH_RECORD_FILTER_ATTRIBUTE_HOLDER,
+  FH_RECORD_OPACITY_FILTER,
+  FH_RECORD_SHADOW_FILTER,
+  FH_RECORD_GLOW_FILTER,
+  FH_RECORD_TILE_FILL,
+  FH_RECORD_SYMBOL_CLASS,
+  FH_RECORD_SYMBOL_INSTANCE,
+  FH_RECORD_PATTERN_FILL,
+  FH_RECORD_LINE_PATTERN,
+  FH_RECORD_ARROW_PATH
+};
+
+// Where a record lives: which store, and at which position in it
+struct FHRecordSlot
+{
+  FHRecordSlot() : m_type(FH_RECORD_NONE), m_index(0) {}
+  unsigned char m_type;
+  unsigned m_index;
+};
+
+typedef std::vector<FHRecordSlot> FHRecordIndex;
+
+/* Contiguous storage for the records of one type.
+ *
+ * Record ids are dense, so all stores share one index, addressed
+ * directly by record id. The interface follows std::map closely
+ * enough for the collector's lookups.
+ */
+template <typename T, FHRecordType Type>
+class FHRecordStore
+{
+public:
+  typedef typename std::vector<std::pair<unsigned, T> >::const_iterator const_iterator;
+
+  explicit FHRecordStore(FHRecordIndex &index) : m_index(index), m_records() {}
+
+  T &operator[](unsigned id)
+  {
+    if (id >= m_index.size())
+      m_index.resize(id + 1);
+    FHRecordSlot &slot = m_index[id];
+    if (slot.m_type != Type)
+    {
+      slot.m_type = Type;
+      slot.m_index = m_records.size();
+      m_records.push_back(std::make_pair(id, T()));
+    }
+    return m_records[slot.m_index].second;
+  }
+
+  const_iterator find(unsigned id) const
+  {
+    if (id >= m_index.size() || m_index[id].m_type != Type)
+      return m_records.end();
+    return m_records.begin() + m_index[id].m_index;
+  }
+
+  const_iterator begin() const
+  {
+    return m_records.begin();
+  }
+
+  const_iterator end() const
+  {
+    return m_records.end();
+  }
+
+  bool empty() const
+  {
+    return m_records.empty();
+  }
+
+  unsigned size() const
+  {
+    return m_records.size();
+  }
+
+private:
+  FHRecordStore(const FHRecordStore &);
+  FHRecordStore &operator=(const FHRecordStore &);
+
+  FHRecordIndex &m_index;
+  std::vector<std::pair<unsigned, T> > m_records;
+};
+
+} // namespace libfreehand
+
+#endif /* __FHRECORDSTORE_H__ */
+/* vim:set shiftwidth=2 softtabstop=2 expandtab: */
@@ -25,6 +25,22 @@ libfreehand::FHTransform::FHTransform(double m11, double m21, double m12, double
 libfreehand::FHTransform::FHTransform(const FHTransform &trafo) = default;
 libfreehand::FHTransform &libfreehand::FHTransform::operator=(const FHTransform &trafo) = default;
 
+void libfreehand::FHTransform::multiply(const FHTransform &trafo)
+{
+  double m11 = trafo.m_m11*m_m11 + trafo.m_m12*m_m21;
+  double m21 = trafo.m_m21*m_m11 + trafo.m_m22*m_m21;
+  double m12 = trafo.m_m11*m_m12 + trafo.m_m12*m_m22;
+  double m22 = trafo.m_m21*m_m12 + trafo.m_m22*m_m22;
+  double m13 = trafo.m_m11*m_m13 + trafo.m_m12*m_m23 + trafo.m_m13;
+  double m23 = trafo.m_m21*m_m13 + trafo.m_m22*m_m23 + trafo.m_m23;
+  m_m11 = m11;
+  m_m21 = m21;
+  m_m12 = m12;
+  m_m22 = m22;
+  m_m13 = m13;
+  m_m23 = m23;
+}
+
 void libfreehand::FHTransform::applyToPoint(double &x, double &y) const
 {
   double tmpX = m_m11*x + m_m12*y+m_m13;
@@ -20,6 +20,8 @@ struct FHTransform
   FHTransform(const FHTransform &trafo);
   FHTransform &operator=(const FHTransform &trafo);
 
+  // Makes this transform apply trafo after itself.
+  void multiply(const FHTransform &trafo);
   void applyToPoint(double &x, double &y) const;
   void applyToArc(double &rx, double &ry, double &rotation, bool &sweep, double &endx, double &endy) const;
 
@@ -62,8 +62,9 @@ struct FHLayer
 {
   unsigned m_graphicStyleId;
   unsigned m_elementsId;
+  unsigned m_nameId;
   unsigned m_visibility;
-  FHLayer() : m_graphicStyleId(0), m_elementsId(0), m_visibility(0) {}
+  FHLayer() : m_graphicStyleId(0), m_elementsId(0), m_nameId(0), m_visibility(0) {}
 };
 
 struct FHGroup
@@ -474,6 +475,10 @@ struct FHBoundingBox
   {
     return ((m_xmin < m_xmax) && (m_ymin < m_ymax));
   }
+  bool intersects(const FHBoundingBox &bBox) const
+  {
+    return m_xmin <= bBox.m_xmax && bBox.m_xmin <= m_xmax && m_ymin <= bBox.m_ymax && bBox.m_ymin <= m_ymax;
+  }
 };
 
 } // namespace libfreehand
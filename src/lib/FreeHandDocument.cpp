@@ -104,6 +104,18 @@ librevenge::RVNGDrawingInterface class implementation when needed. This is often
 \return A value that indicates whether the parsing was successful
 */
 FHAPI bool FreeHandDocument::parse(librevenge::RVNGInputStream *input, librevenge::RVNGDrawingInterface *painter)
+{
+  return parse(input, painter, FHParseOptions());
+}
+
+/**
+Parses the input stream content, like parse(input, painter), with the given options.
+\param input The input stream
+\param painter A librevenge::RVNGDrawingerInterface implementation
+\param options The parse options
+\return A value that indicates whether the parsing was successful
+*/
+FHAPI bool FreeHandDocument::parse(librevenge::RVNGInputStream *input, librevenge::RVNGDrawingInterface *painter, const FHParseOptions &options)
 {
   if (!input)
     return false;
@@ -113,7 +125,7 @@ FHAPI bool FreeHandDocument::parse(librevenge::RVNGInputStream *input, libreveng
     input->seek(0, librevenge::RVNG_SEEK_SET);
     if (findAGD(input))
     {
-      FHParser parser;
+      FHParser parser(options);
       if (!parser.parse(input, painter))
         return false;
     }
@@ -127,6 +139,33 @@ FHAPI bool FreeHandDocument::parse(librevenge::RVNGInputStream *input, libreveng
   return false;
 }
 
+/**
+Reads the page size, the FreeHand version, the layers and the numbers of
+paths, texts and images of a document, without parsing the drawing.
+\param input The input stream
+\param info The document information, filled in
+\return A value that indicates whether the information could be read
+*/
+FHAPI bool FreeHandDocument::getInfo(librevenge::RVNGInputStream *input, FHDocumentInfo &info)
+{
+  if (!input)
+    return false;
+
+  try
+  {
+    input->seek(0, librevenge::RVNG_SEEK_SET);
+    if (findAGD(input))
+    {
+      FHParser parser;
+      return parser.getInfo(input, info);
+    }
+  }
+  catch (...)
+  {
+  }
+  return false;
+}
+
 }
 
 /* vim:set shiftwidth=2 softtabstop=2 expandtab: */
@@ -0,0 +1,221 @@
+/* -*- Mode: C++; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/*
+ * This file is part of the libfreehand project.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include <string>
+#include <vector>
+
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <librevenge/librevenge.h>
+
+#include "FHCollector.h"
+
+namespace test
+{
+
+namespace
+{
+
+librevenge::RVNGBinaryData makeData(const char *bytes)
+{
+  return librevenge::RVNGBinaryData((const unsigned char *)bytes, std::string(bytes).size());
+}
+
+libfreehand::FHDataList makeDataList(unsigned first, unsigned second = 0)
+{
+  libfreehand::FHDataList list;
+  list.m_elements.push_back(first);
+  if (second)
+    list.m_elements.push_back(second);
+  return list;
+}
+
+std::string toString(const librevenge::RVNGBinaryData &data)
+{
+  return std::string((const char *)data.getDataBuffer(), data.size());
+}
+
+libfreehand::FHList makeList(const std::vector<unsigned> &elements)
+{
+  libfreehand::FHList list;
+  list.m_elements = elements;
+  return list;
+}
+
+// A square, in points
+libfreehand::FHPath makeSquare(double x, double y, double size, unsigned graphicStyleId)
+{
+  libfreehand::FHPath path;
+  path.appendMoveTo(x, y);
+  path.appendLineTo(x + size, y);
+  path.appendLineTo(x + size, y + size);
+  path.appendLineTo(x, y + size);
+  path.appendClosePath();
+  path.setGraphicStyleId(graphicStyleId);
+  return path;
+}
+
+// Collects a tile fill of a group and the property list that fills with it
+void collectTileFill(libfreehand::FHCollector &collector, unsigned nameId, unsigned tileFillId, unsigned propListId, unsigned groupId)
+{
+  collector.collectName(nameId, "fill");
+  libfreehand::FHTileFill tileFill;
+  tileFill.m_groupId = groupId;
+  tileFill.m_scaleX = 1;
+  tileFill.m_scaleY = 1;
+  collector.collectTileFill(tileFillId, tileFill);
+  libfreehand::FHPropList propList;
+  propList.m_elements[nameId] = tileFillId;
+  collector.collectPropList(propListId, propList);
+}
+
+// Collects a single visible layer with the elements, and draws the document
+std::vector<std::string> drawFillImages(libfreehand::FHCollector &collector, unsigned firstId, const std::vector<unsigned> &elements)
+{
+  collector.collectList(firstId, makeList(elements));
+  libfreehand::FHLayer layer;
+  layer.m_elementsId = firstId;
+  layer.m_visibility = 3;
+  collector.collectLayer(firstId + 1, layer);
+  collector.collectList(firstId + 2, makeList(std::vector<unsigned>(1, firstId + 1)));
+  collector.collectBlock(firstId + 3, libfreehand::FHBlock(firstId + 2));
+  libfreehand::FHTail tail;
+  tail.m_blockId = firstId + 3;
+  tail.m_pageInfo.m_maxX = 612;
+  tail.m_pageInfo.m_maxY = 792;
+  collector.collectFHTail(firstId + 4, tail);
+
+  librevenge::RVNGStringVector svgOutput;
+  librevenge::RVNGSVGDrawingGenerator generator(svgOutput, "svg");
+  collector.outputDrawing(&generator);
+  CPPUNIT_ASSERT_EQUAL(1U, svgOutput.size());
+
+  std::vector<std::string> images;
+  const std::string svg(svgOutput[0].cstr());
+  const std::string prefix("data:image/svg+xml;base64,");
+  for (std::string::size_type pos = svg.find(prefix); pos != std::string::npos; pos = svg.find(prefix, pos + 1))
+  {
+    const std::string::size_type start = pos + prefix.size();
+    images.push_back(svg.substr(start, svg.find('"', start) - start));
+  }
+  return images;
+}
+
+}
+
+class FHCollectorTest : public CPPUNIT_NS::TestFixture
+{
+public:
+  virtual void setUp();
+  virtual void tearDown();
+
+private:
+  CPPUNIT_TEST_SUITE(FHCollectorTest);
+  CPPUNIT_TEST(testImageData);
+  CPPUNIT_TEST(testTileFill);
+  CPPUNIT_TEST(testCyclicTileFill);
+  CPPUNIT_TEST_SUITE_END();
+
+private:
+  void testImageData();
+  void testTileFill();
+  void testCyclicTileFill();
+};
+
+void FHCollectorTest::setUp()
+{
+}
+
+void FHCollectorTest::tearDown()
+{
+}
+
+void FHCollectorTest::testImageData()
+{
+  libfreehand::FHCollector collector;
+  collector.collectData(1, makeData("abc"));
+  collector.collectData(2, makeData("def"));
+  collector.collectData(3, makeData("abc"));
+  collector.collectData(4, makeData("def"));
+  collector.collectDataList(5, makeDataList(1, 2));
+  collector.collectDataList(6, makeDataList(3, 4));
+  collector.collectDataList(7, makeDataList(2, 1));
+  collector.collectDataList(8, makeDataList(1));
+
+  const librevenge::RVNGBinaryData image = collector.getImageData(5);
+  CPPUNIT_ASSERT_EQUAL(std::string("abcdef"), toString(image));
+  // equal bytes from other chunks share the storage
+  const librevenge::RVNGBinaryData equalImage = collector.getImageData(6);
+  CPPUNIT_ASSERT_EQUAL(std::string("abcdef"), toString(equalImage));
+  CPPUNIT_ASSERT(image.getDataBuffer() == equalImage.getDataBuffer());
+  CPPUNIT_ASSERT(image.getDataBuffer() == collector.getImageData(5).getDataBuffer());
+
+  // the chunks are still there for the other lists that use them
+  CPPUNIT_ASSERT_EQUAL(std::string("defabc"), toString(collector.getImageData(7)));
+  CPPUNIT_ASSERT_EQUAL(std::string("abc"), toString(collector.getImageData(8)));
+  CPPUNIT_ASSERT(collector.getImageData(9).empty());
+}
+
+void FHCollectorTest::testTileFill()
+{
+  libfreehand::FHCollector collector;
+  collector.collectPath(1, makeSquare(0, 0, 10, 0));
+  collector.collectList(2, makeList(std::vector<unsigned>(1, 1)));
+  libfreehand::FHGroup group;
+  group.m_elementsId = 2;
+  collector.collectGroup(3, group);
+  collectTileFill(collector, 4, 5, 6, 3);
+  collector.collectPath(7, makeSquare(100, 100, 100, 6));
+  collector.collectPath(8, makeSquare(300, 300, 50, 6));
+  std::vector<unsigned> elements;
+  elements.push_back(7);
+  elements.push_back(8);
+
+  // the second path reuses the rendering of the tile
+  const std::vector<std::string> images = drawFillImages(collector, 9, elements);
+  CPPUNIT_ASSERT_EQUAL(std::vector<std::string>::size_type(2), images.size());
+  CPPUNIT_ASSERT(!images[0].empty());
+  CPPUNIT_ASSERT_EQUAL(images[0], images[1]);
+}
+
+void FHCollectorTest::testCyclicTileFill()
+{
+  // The tile holds a square and the group of the first filled path
+  libfreehand::FHCollector collector;
+  collector.collectPath(1, makeSquare(0, 0, 10, 0));
+  std::vector<unsigned> tileElements;
+  tileElements.push_back(1);
+  tileElements.push_back(9);
+  collector.collectList(2, makeList(tileElements));
+  libfreehand::FHGroup group;
+  group.m_elementsId = 2;
+  collector.collectGroup(3, group);
+  collectTileFill(collector, 4, 5, 6, 3);
+  collector.collectPath(7, makeSquare(100, 100, 100, 6));
+  collector.collectList(8, makeList(std::vector<unsigned>(1, 7)));
+  group.m_elementsId = 8;
+  collector.collectGroup(9, group);
+  collector.collectPath(10, makeSquare(300, 300, 50, 6));
+  std::vector<unsigned> elements;
+  elements.push_back(9);
+  elements.push_back(10);
+
+  // Inside of its group, the tile leaves out that group. The second path
+  // is outside of the group, so its tile is complete.
+  const std::vector<std::string> images = drawFillImages(collector, 11, elements);
+  CPPUNIT_ASSERT_EQUAL(std::vector<std::string>::size_type(2), images.size());
+  CPPUNIT_ASSERT(images[0] != images[1]);
+}
+
+CPPUNIT_TEST_SUITE_REGISTRATION(FHCollectorTest);
+
+}
+
+/* vim:set shiftwidth=2 softtabstop=2 expandtab: */
@@ -0,0 +1,129 @@
+/* -*- Mode: C++; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/*
+ * This file is part of the libfreehand project.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include <math.h>
+#include <vector>
+
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "FHColorConversion.h"
+
+namespace test
+{
+
+namespace
+{
+
+double toLinear(unsigned short value)
+{
+  const double v = value / 65535.0;
+  return v <= 0.04045 ? v / 12.92 : pow((v + 0.055) / 1.055, 2.4);
+}
+
+double labF(double t)
+{
+  return t > 216.0 / 24389.0 ? cbrt(t) : (24389.0 / 27.0 * t + 16.0) / 116.0;
+}
+
+void toLab(const unsigned short *rgb, double *lab)
+{
+  const double r = toLinear(rgb[0]);
+  const double g = toLinear(rgb[1]);
+  const double b = toLinear(rgb[2]);
+  const double x = labF((0.4124 * r + 0.3576 * g + 0.1805 * b) / 0.95047);
+  const double y = labF(0.2126 * r + 0.7152 * g + 0.0722 * b);
+  const double z = labF((0.0193 * r + 0.1192 * g + 0.9505 * b) / 1.08883);
+  lab[0] = 116.0 * y - 16.0;
+  lab[1] = 500.0 * (x - y);
+  lab[2] = 200.0 * (y - z);
+}
+
+// CIE76
+double deltaE(const unsigned short *rgb1, const unsigned short *rgb2)
+{
+  double lab1[3];
+  double lab2[3];
+  toLab(rgb1, lab1);
+  toLab(rgb2, lab2);
+  return sqrt((lab1[0] - lab2[0]) * (lab1[0] - lab2[0]) + (lab1[1] - lab2[1]) * (lab1[1] - lab2[1]) + (lab1[2] - lab2[2]) * (lab1[2] - lab2[2]));
+}
+
+}
+
+class FHColorConversionTest : public CPPUNIT_NS::TestFixture
+{
+public:
+  virtual void setUp();
+  virtual void tearDown();
+
+private:
+  CPPUNIT_TEST_SUITE(FHColorConversionTest);
+  CPPUNIT_TEST(testSharedTransform);
+  CPPUNIT_TEST(testLookupTable);
+  CPPUNIT_TEST_SUITE_END();
+
+private:
+  void testSharedTransform();
+  void testLookupTable();
+};
+
+void FHColorConversionTest::setUp()
+{
+}
+
+void FHColorConversionTest::tearDown()
+{
+}
+
+void FHColorConversionTest::testSharedTransform()
+{
+  CPPUNIT_ASSERT(libfreehand::getCMYKTransform());
+  CPPUNIT_ASSERT(libfreehand::getCMYKTransform() == libfreehand::getCMYKTransform());
+  CPPUNIT_ASSERT(!libfreehand::getCMYKLookupTable().empty());
+  CPPUNIT_ASSERT(libfreehand::FHCMYKLookupTable(nullptr).empty());
+}
+
+void FHColorConversionTest::testLookupTable()
+{
+  // the corners of the CMYK cube, then pseudo-random colors
+  std::vector<unsigned short> cmyk;
+  for (unsigned i = 0; i < 16; ++i)
+    for (unsigned j = 0; j < 4; ++j)
+      cmyk.push_back((i >> j) & 1 ? 65535 : 0);
+  unsigned seed = 1;
+  for (unsigned i = 0; i < 4 * 20000; ++i)
+  {
+    seed = seed * 1103515245 + 12345;
+    cmyk.push_back((unsigned short)(seed >> 16));
+  }
+  const unsigned count = cmyk.size() / 4;
+
+  std::vector<unsigned short> expected(3 * count);
+  std::vector<unsigned short> rgb(3 * count);
+  cmsDoTransform(libfreehand::getCMYKTransform(), &cmyk[0], &expected[0], count);
+  libfreehand::getCMYKLookupTable().convert(&cmyk[0], &rgb[0], count);
+
+  double sum = 0.0;
+  for (unsigned i = 0; i < count; ++i)
+  {
+    const double d = deltaE(&expected[3 * i], &rgb[3 * i]);
+    CPPUNIT_ASSERT(d < 3.0);
+    if (i < 16) // grid points
+      CPPUNIT_ASSERT(d < 0.01);
+    sum += d;
+  }
+  CPPUNIT_ASSERT(sum / count < 1.0);
+}
+
+CPPUNIT_TEST_SUITE_REGISTRATION(FHColorConversionTest);
+
+}
+
+/* vim:set shiftwidth=2 softtabstop=2 expandtab: */
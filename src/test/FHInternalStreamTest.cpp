@@ -8,6 +8,9 @@
  */
 
 #include <algorithm>
+#include <vector>
+
+#include <zlib.h>
 
 #include <cppunit/TestFixture.h>
 #include <cppunit/extensions/HelperMacros.h>
@@ -15,6 +18,7 @@
 #include <librevenge/librevenge.h>
 
 #include "FHInternalStream.h"
+#include "libfreehand_utils.h"
 
 namespace test
 {
@@ -31,11 +35,21 @@ private:
   CPPUNIT_TEST_SUITE(FHInternalStreamTest);
   CPPUNIT_TEST(testRead);
   CPPUNIT_TEST(testSeek);
+  CPPUNIT_TEST(testBorrowed);
+  CPPUNIT_TEST(testCompressed);
+  CPPUNIT_TEST(testLazy);
+  CPPUNIT_TEST(testBroken);
+  CPPUNIT_TEST(testReaders);
   CPPUNIT_TEST_SUITE_END();
 
 private:
   void testRead();
   void testSeek();
+  void testBorrowed();
+  void testCompressed();
+  void testLazy();
+  void testBroken();
+  void testReaders();
 };
 
 void FHInternalStreamTest::setUp()
@@ -101,6 +115,168 @@ void FHInternalStreamTest::testSeek()
   CPPUNIT_ASSERT((sizeof(data) - 1) == strm.tell());
 }
 
+void FHInternalStreamTest::testBorrowed()
+{
+  const unsigned char data[] = "abc dee fgh";
+  FHInternalStream strm(data, sizeof(data));
+
+  CPPUNIT_ASSERT(sizeof(data) == strm.getSize());
+
+  unsigned long readBytes = 0;
+  const unsigned char *s = strm.read(sizeof(data), readBytes);
+  CPPUNIT_ASSERT(sizeof(data) == readBytes);
+  CPPUNIT_ASSERT_MESSAGE("data were copied", data == s);
+  CPPUNIT_ASSERT(strm.isEnd());
+
+  strm.seek(4, librevenge::RVNG_SEEK_SET);
+  s = strm.read(3, readBytes);
+  CPPUNIT_ASSERT(3 == readBytes);
+  CPPUNIT_ASSERT_MESSAGE("data were copied", data + 4 == s);
+
+  CPPUNIT_ASSERT(0 != strm.seek(1, librevenge::RVNG_SEEK_END));
+  CPPUNIT_ASSERT(strm.isEnd());
+  CPPUNIT_ASSERT(sizeof(data) == strm.tell());
+
+  const unsigned char *const noData = nullptr;
+  FHInternalStream empty(noData, 10);
+  CPPUNIT_ASSERT(0 == empty.getSize());
+  CPPUNIT_ASSERT(empty.isEnd());
+  CPPUNIT_ASSERT(!empty.read(1, readBytes));
+  CPPUNIT_ASSERT(0 == readBytes);
+}
+
+void FHInternalStreamTest::testCompressed()
+{
+  // highly compressible, so that the output buffer has to grow several times
+  std::vector<unsigned char> data(300000);
+  for (std::vector<unsigned char>::size_type i = 0; i != data.size(); ++i)
+    data[i] = (unsigned char)((i / 7) % 5);
+
+  uLongf compressedSize = compressBound(data.size());
+  std::vector<unsigned char> compressed(compressedSize);
+  CPPUNIT_ASSERT(Z_OK == compress(&compressed[0], &compressedSize, &data[0], data.size()));
+  CPPUNIT_ASSERT(compressedSize * 4 < data.size());
+
+  librevenge::RVNGBinaryData binData(&compressed[0], compressedSize);
+  FHInternalStream strm(binData.getDataStream(), binData.size(), true);
+
+  CPPUNIT_ASSERT(data.size() == strm.getSize());
+  unsigned long readBytes = 0;
+  const unsigned char *s = strm.read(data.size(), readBytes);
+  CPPUNIT_ASSERT(data.size() == readBytes);
+  CPPUNIT_ASSERT(std::equal(data.begin(), data.end(), s));
+  CPPUNIT_ASSERT(strm.isEnd());
+}
+
+void FHInternalStreamTest::testLazy()
+{
+  std::vector<unsigned char> data(300000);
+  for (std::vector<unsigned char>::size_type i = 0; i != data.size(); ++i)
+    data[i] = (unsigned char)(i * 13 + (i >> 9));
+
+  uLongf compressedSize = compressBound(data.size());
+  std::vector<unsigned char> compressed(compressedSize);
+  CPPUNIT_ASSERT(Z_OK == compress(&compressed[0], &compressedSize, &data[0], data.size()));
+  compressed.resize(compressedSize);
+
+  {
+    FHInternalStream strm(&compressed[0], compressed.size(), true);
+
+    CPPUNIT_ASSERT(!strm.isEnd());
+    CPPUNIT_ASSERT(0 == strm.seek(200000, librevenge::RVNG_SEEK_SET));
+    unsigned long readBytes = 0;
+    const unsigned char *s = strm.read(16, readBytes);
+    CPPUNIT_ASSERT(16 == readBytes);
+    CPPUNIT_ASSERT(std::equal(data.begin() + 200000, data.begin() + 200016, s));
+
+    // seeking back does not need to inflate anything again
+    CPPUNIT_ASSERT(0 == strm.seek(10, librevenge::RVNG_SEEK_SET));
+    s = strm.read(16, readBytes);
+    CPPUNIT_ASSERT(16 == readBytes);
+    CPPUNIT_ASSERT(std::equal(data.begin() + 10, data.begin() + 26, s));
+
+    CPPUNIT_ASSERT(0 == strm.seek(-4, librevenge::RVNG_SEEK_END));
+    CPPUNIT_ASSERT(data.size() - 4 == (unsigned long)strm.tell());
+    CPPUNIT_ASSERT(data.size() == strm.getSize());
+    CPPUNIT_ASSERT(0 != strm.seek(data.size() + 1, librevenge::RVNG_SEEK_SET));
+    CPPUNIT_ASSERT(strm.isEnd());
+  }
+
+  // nothing is inflated until it is needed, so the compressed data are not copied
+  FHInternalStream strm(&compressed[0], compressed.size(), true);
+  unsigned long readBytes = 0;
+  const unsigned char *s = strm.read(1000, readBytes);
+  CPPUNIT_ASSERT(1000 == readBytes);
+  CPPUNIT_ASSERT(std::equal(data.begin(), data.begin() + 1000, s));
+}
+
+void FHInternalStreamTest::testBroken()
+{
+  std::vector<unsigned char> data(300000);
+  for (std::vector<unsigned char>::size_type i = 0; i != data.size(); ++i)
+    data[i] = (unsigned char)(i * 13 + (i >> 9));
+
+  uLongf compressedSize = compressBound(data.size());
+  std::vector<unsigned char> compressed(compressedSize);
+  CPPUNIT_ASSERT(Z_OK == compress(&compressed[0], &compressedSize, &data[0], data.size()));
+  compressed.resize(compressedSize);
+
+  std::vector<std::vector<unsigned char> > brokenInputs;
+  // truncated
+  brokenInputs.push_back(std::vector<unsigned char>(compressed.begin(), compressed.begin() + compressed.size() / 2));
+  // corrupt in the middle
+  brokenInputs.push_back(compressed);
+  brokenInputs.back()[compressed.size() / 2] ^= 0xff;
+  brokenInputs.back()[compressed.size() / 2 + 1] ^= 0xff;
+  // with a broken checksum
+  brokenInputs.push_back(compressed);
+  brokenInputs.back().back() ^= 0xff;
+
+  // Both modes end the stream where the valid data end
+  for (const std::vector<unsigned char> &broken : brokenInputs)
+  {
+    librevenge::RVNGBinaryData binData(&broken[0], broken.size());
+    FHInternalStream eager(binData.getDataStream(), binData.size(), true);
+    FHInternalStream lazy(&broken[0], broken.size(), true);
+
+    unsigned long readBytes = 0;
+    const unsigned char *s = lazy.read(1000, readBytes);
+    CPPUNIT_ASSERT(1000 == readBytes);
+    CPPUNIT_ASSERT(std::equal(data.begin(), data.begin() + 1000, s));
+
+    const unsigned long size = eager.getSize();
+    CPPUNIT_ASSERT(size <= data.size());
+    CPPUNIT_ASSERT_EQUAL(size, lazy.getSize());
+    lazy.seek(0, librevenge::RVNG_SEEK_SET);
+    s = lazy.read(size, readBytes);
+    CPPUNIT_ASSERT(size == readBytes);
+    const unsigned char *const e = eager.read(size, readBytes);
+    CPPUNIT_ASSERT(size == readBytes);
+    CPPUNIT_ASSERT(std::equal(s, s + size, e));
+    CPPUNIT_ASSERT(eager.isEnd());
+    CPPUNIT_ASSERT(lazy.isEnd());
+  }
+}
+
+void FHInternalStreamTest::testReaders()
+{
+  const unsigned char data[] = { 0x12, 0x34, 0x56, 0x78, 0xff, 0xfe, 0x80 };
+  FHInternalStream strm(data, sizeof(data));
+
+  CPPUNIT_ASSERT_EQUAL(uint32_t(0x12345678), libfreehand::readU32(&strm));
+  CPPUNIT_ASSERT_EQUAL(int16_t(-2), libfreehand::readS16(&strm));
+  CPPUNIT_ASSERT(6 == strm.tell());
+  CPPUNIT_ASSERT_THROW(libfreehand::readU16(&strm), libfreehand::EndOfStreamException);
+  CPPUNIT_ASSERT(strm.isEnd());
+
+  strm.seek(1, librevenge::RVNG_SEEK_SET);
+  CPPUNIT_ASSERT_EQUAL(uint16_t(0x3456), libfreehand::readU16(&strm));
+  CPPUNIT_ASSERT_EQUAL(uint8_t(0x78), libfreehand::readU8(&strm));
+  strm.seek(-1, librevenge::RVNG_SEEK_END);
+  CPPUNIT_ASSERT_EQUAL(int8_t(-128), libfreehand::readS8(&strm));
+  CPPUNIT_ASSERT_THROW(libfreehand::readU8(&strm), libfreehand::EndOfStreamException);
+}
+
 CPPUNIT_TEST_SUITE_REGISTRATION(FHInternalStreamTest);
 
 }
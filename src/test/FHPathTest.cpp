@@ -0,0 +1,196 @@
+/* -*- Mode: C++; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/*
+ * This file is part of the libfreehand project.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <librevenge/librevenge.h>
+
+#include "FHPath.h"
+#include "FHTransform.h"
+#include "FHTypes.h"
+
+namespace test
+{
+
+using libfreehand::FHBoundingBox;
+using libfreehand::FHPath;
+using libfreehand::FHTransform;
+
+class FHPathTest : public CPPUNIT_NS::TestFixture
+{
+public:
+  virtual void setUp();
+  virtual void tearDown();
+
+private:
+  CPPUNIT_TEST_SUITE(FHPathTest);
+  CPPUNIT_TEST(testWriteOut);
+  CPPUNIT_TEST(testCopy);
+  CPPUNIT_TEST(testTransform);
+  CPPUNIT_TEST(testBoundingBox);
+  CPPUNIT_TEST(testIntersects);
+  CPPUNIT_TEST_SUITE_END();
+
+private:
+  void testWriteOut();
+  void testCopy();
+  void testTransform();
+  void testBoundingBox();
+  void testIntersects();
+};
+
+void FHPathTest::setUp()
+{
+}
+
+void FHPathTest::tearDown()
+{
+}
+
+void FHPathTest::testWriteOut()
+{
+  FHPath path;
+  CPPUNIT_ASSERT(path.empty());
+  path.appendMoveTo(1, 2);
+  path.appendLineTo(3, 4);
+  path.appendCubicBezierTo(5, 6, 7, 8, 9, 10);
+  path.appendQuadraticBezierTo(11, 12, 13, 14);
+  path.appendArcTo(1, 2, 0, true, false, 15, 16);
+  CPPUNIT_ASSERT(!path.empty());
+  CPPUNIT_ASSERT_EQUAL(15.0, path.getX());
+  CPPUNIT_ASSERT_EQUAL(16.0, path.getY());
+
+  librevenge::RVNGPropertyListVector vec;
+  path.writeOut(vec);
+  CPPUNIT_ASSERT_EQUAL(5UL, vec.count());
+  CPPUNIT_ASSERT(vec[0]["librevenge:path-action"]->getStr() == "M");
+  CPPUNIT_ASSERT_EQUAL(2.0, vec[0]["svg:y"]->getDouble());
+  CPPUNIT_ASSERT(vec[1]["librevenge:path-action"]->getStr() == "L");
+  CPPUNIT_ASSERT(vec[2]["librevenge:path-action"]->getStr() == "C");
+  CPPUNIT_ASSERT_EQUAL(7.0, vec[2]["svg:x2"]->getDouble());
+  CPPUNIT_ASSERT_EQUAL(10.0, vec[2]["svg:y"]->getDouble());
+  CPPUNIT_ASSERT(vec[3]["librevenge:path-action"]->getStr() == "Q");
+  CPPUNIT_ASSERT_EQUAL(13.0, vec[3]["svg:x"]->getDouble());
+  CPPUNIT_ASSERT(vec[4]["librevenge:path-action"]->getStr() == "A");
+  CPPUNIT_ASSERT(vec[4]["librevenge:large-arc"]->getStr() == "true");
+  CPPUNIT_ASSERT(vec[4]["librevenge:sweep"]->getStr() == "false");
+  CPPUNIT_ASSERT_EQUAL(16.0, vec[4]["svg:y"]->getDouble());
+}
+
+void FHPathTest::testCopy()
+{
+  FHPath path;
+  path.appendMoveTo(1, 2);
+  path.appendLineTo(3, 4);
+  path.appendClosePath();
+  path.setGraphicStyleId(7);
+  path.setEvenOdd(true);
+
+  FHPath copy(path);
+  CPPUNIT_ASSERT(copy.isClosed());
+  CPPUNIT_ASSERT_EQUAL(7U, copy.getGraphicStyleId());
+  CPPUNIT_ASSERT(copy.getEvenOdd());
+  CPPUNIT_ASSERT_EQUAL(path.getPathString(), copy.getPathString());
+
+  copy.appendPath(path);
+  CPPUNIT_ASSERT_EQUAL(path.getPathString() + path.getPathString(), copy.getPathString());
+
+  // the copy is independent of the original
+  copy.transform(FHTransform(1, 0, 0, 1, 10, 10));
+  CPPUNIT_ASSERT_EQUAL(3.0, path.getX());
+  CPPUNIT_ASSERT_EQUAL(13.0, copy.getX());
+
+  copy.clear();
+  CPPUNIT_ASSERT(copy.empty());
+  CPPUNIT_ASSERT(!copy.isClosed());
+  CPPUNIT_ASSERT_EQUAL(0.0, copy.getX());
+}
+
+void FHPathTest::testTransform()
+{
+  FHPath path;
+  path.appendMoveTo(1, 0);
+  path.appendCubicBezierTo(1, 1, 2, 2, 3, 0);
+  path.appendArcTo(1, 1, 0, false, true, 5, 0);
+  // mirror at the x axis and move by (1, 2)
+  path.transform(FHTransform(1, 0, 0, -1, 1, 2));
+
+  librevenge::RVNGPropertyListVector vec;
+  path.writeOut(vec);
+  CPPUNIT_ASSERT_EQUAL(2.0, vec[0]["svg:x"]->getDouble());
+  CPPUNIT_ASSERT_EQUAL(2.0, vec[0]["svg:y"]->getDouble());
+  CPPUNIT_ASSERT_EQUAL(1.0, vec[1]["svg:y1"]->getDouble());
+  CPPUNIT_ASSERT_EQUAL(3.0, vec[1]["svg:x2"]->getDouble());
+  CPPUNIT_ASSERT_EQUAL(0.0, vec[1]["svg:y2"]->getDouble());
+  CPPUNIT_ASSERT_EQUAL(6.0, vec[2]["svg:x"]->getDouble());
+  CPPUNIT_ASSERT_EQUAL(2.0, vec[2]["svg:y"]->getDouble());
+  // mirroring flips the direction of the arc
+  CPPUNIT_ASSERT(vec[2]["librevenge:sweep"]->getStr() == "false");
+}
+
+void FHPathTest::testBoundingBox()
+{
+  FHPath path;
+  path.appendMoveTo(0, 0);
+  path.appendLineTo(4, 0);
+  path.appendQuadraticBezierTo(6, 2, 4, 4);
+  path.appendCubicBezierTo(4, 6, 0, 6, 0, 4);
+
+  double xmin = 0, ymin = 0, xmax = 0, ymax = 0;
+  path.getBoundingBox(xmin, ymin, xmax, ymax);
+  CPPUNIT_ASSERT_DOUBLES_EQUAL(0.0, xmin, 1e-9);
+  CPPUNIT_ASSERT_DOUBLES_EQUAL(0.0, ymin, 1e-9);
+  CPPUNIT_ASSERT_DOUBLES_EQUAL(5.0, xmax, 1e-9);
+  CPPUNIT_ASSERT_DOUBLES_EQUAL(5.5, ymax, 1e-9);
+}
+
+void FHPathTest::testIntersects()
+{
+  FHBoundingBox a;
+  a.m_xmin = 0;
+  a.m_ymin = 0;
+  a.m_xmax = 2;
+  a.m_ymax = 2;
+  FHBoundingBox b;
+  b.m_xmin = 1;
+  b.m_ymin = 1;
+  b.m_xmax = 3;
+  b.m_ymax = 3;
+  CPPUNIT_ASSERT(a.intersects(b));
+  CPPUNIT_ASSERT(b.intersects(a));
+
+  // touching counts
+  b.m_xmin = 2;
+  b.m_xmax = 3;
+  CPPUNIT_ASSERT(a.intersects(b));
+
+  // overlapping in x only
+  b.m_ymin = 2.5;
+  CPPUNIT_ASSERT(!a.intersects(b));
+  CPPUNIT_ASSERT(!b.intersects(a));
+
+  // inside
+  b.m_xmin = 0.5;
+  b.m_ymin = 0.5;
+  b.m_xmax = 1;
+  b.m_ymax = 1;
+  CPPUNIT_ASSERT(a.intersects(b));
+  CPPUNIT_ASSERT(b.intersects(a));
+
+  // a degenerate box still has a position
+  b.m_xmin = b.m_xmax = 5;
+  CPPUNIT_ASSERT(!a.intersects(b));
+}
+
+CPPUNIT_TEST_SUITE_REGISTRATION(FHPathTest);
+
+}
+
+/* vim:set shiftwidth=2 softtabstop=2 expandtab: */
@@ -0,0 +1,94 @@
+/* -*- Mode: C++; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/*
+ * This file is part of the libfreehand project.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "FHRecordStore.h"
+
+namespace test
+{
+
+using libfreehand::FHRecordIndex;
+using libfreehand::FHRecordStore;
+
+class FHRecordStoreTest : public CPPUNIT_NS::TestFixture
+{
+public:
+  virtual void setUp();
+  virtual void tearDown();
+
+private:
+  CPPUNIT_TEST_SUITE(FHRecordStoreTest);
+  CPPUNIT_TEST(testFind);
+  CPPUNIT_TEST(testSharedIndex);
+  CPPUNIT_TEST_SUITE_END();
+
+private:
+  void testFind();
+  void testSharedIndex();
+};
+
+void FHRecordStoreTest::setUp()
+{
+}
+
+void FHRecordStoreTest::tearDown()
+{
+}
+
+void FHRecordStoreTest::testFind()
+{
+  FHRecordIndex index;
+  FHRecordStore<int, libfreehand::FH_RECORD_PATH> store(index);
+  CPPUNIT_ASSERT(store.empty());
+  CPPUNIT_ASSERT(store.find(0) == store.end());
+  CPPUNIT_ASSERT(store.find(5) == store.end());
+
+  store[3] = 30;
+  store[7] = 70;
+  store[3] = 31;
+  CPPUNIT_ASSERT(!store.empty());
+  CPPUNIT_ASSERT(store.find(3) != store.end());
+  CPPUNIT_ASSERT_EQUAL(3U, store.find(3)->first);
+  CPPUNIT_ASSERT_EQUAL(31, store.find(3)->second);
+  CPPUNIT_ASSERT_EQUAL(70, store.find(7)->second);
+  CPPUNIT_ASSERT(store.find(5) == store.end());
+  CPPUNIT_ASSERT(store.find(100) == store.end());
+
+  // iteration is in the order of collection
+  FHRecordStore<int, libfreehand::FH_RECORD_PATH>::const_iterator iter = store.begin();
+  CPPUNIT_ASSERT_EQUAL(3U, iter->first);
+  ++iter;
+  CPPUNIT_ASSERT_EQUAL(7U, iter->first);
+  ++iter;
+  CPPUNIT_ASSERT(iter == store.end());
+}
+
+void FHRecordStoreTest::testSharedIndex()
+{
+  FHRecordIndex index;
+  FHRecordStore<int, libfreehand::FH_RECORD_GROUP> groups(index);
+  FHRecordStore<int, libfreehand::FH_RECORD_CLIP_GROUP> clipGroups(index);
+
+  groups[1] = 10;
+  clipGroups[2] = 20;
+  CPPUNIT_ASSERT(groups.find(1) != groups.end());
+  CPPUNIT_ASSERT(groups.find(2) == groups.end());
+  CPPUNIT_ASSERT(clipGroups.find(1) == clipGroups.end());
+  CPPUNIT_ASSERT_EQUAL(20, clipGroups.find(2)->second);
+  CPPUNIT_ASSERT_EQUAL(libfreehand::FH_RECORD_GROUP, libfreehand::FHRecordType(index[1].m_type));
+  CPPUNIT_ASSERT_EQUAL(libfreehand::FH_RECORD_CLIP_GROUP, libfreehand::FHRecordType(index[2].m_type));
+}
+
+CPPUNIT_TEST_SUITE_REGISTRATION(FHRecordStoreTest);
+
+}
+
+/* vim:set shiftwidth=2 softtabstop=2 expandtab: */
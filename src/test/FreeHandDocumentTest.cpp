@@ -0,0 +1,545 @@
+/* -*- Mode: C++; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/*
+ * This file is part of the libfreehand project.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <librevenge/librevenge.h>
+#include <libfreehand/libfreehand.h>
+
+#include "FHParser.h"
+
+namespace test
+{
+
+namespace
+{
+
+void appendU8(std::vector<unsigned char> &data, unsigned value)
+{
+  data.push_back((unsigned char)value);
+}
+
+void appendU16(std::vector<unsigned char> &data, unsigned value)
+{
+  appendU8(data, value >> 8);
+  appendU8(data, value);
+}
+
+void appendU32(std::vector<unsigned char> &data, unsigned value)
+{
+  appendU16(data, value >> 16);
+  appendU16(data, value);
+}
+
+// in points
+void appendCoordinate(std::vector<unsigned char> &data, double value)
+{
+  appendU32(data, (unsigned)(int)std::floor(value * 65536 + 0.5));
+}
+
+void appendZeros(std::vector<unsigned char> &data, unsigned count)
+{
+  data.insert(data.end(), count, 0);
+}
+
+// Writes FreeHand 8 documents, with a few kinds of records
+class DocumentBuilder
+{
+public:
+  DocumentBuilder()
+    : m_tokens(), m_records(), m_data() {}
+
+  unsigned addName(const std::string &name)
+  {
+    std::vector<unsigned char> data;
+    const unsigned size = (unsigned)(4 + name.size() + 3) / 4;
+    appendU16(data, size);
+    appendU16(data, (unsigned)name.size());
+    data.insert(data.end(), name.begin(), name.end());
+    appendZeros(data, (size + 1) * 4 - (unsigned)data.size());
+    return addRecord("MName", data);
+  }
+
+  unsigned addList(const std::vector<unsigned> &elements)
+  {
+    std::vector<unsigned char> data;
+    appendU16(data, (unsigned)elements.size());
+    appendU16(data, (unsigned)elements.size());
+    appendZeros(data, 8);
+    for (unsigned element : elements)
+      appendU16(data, element);
+    return addRecord("List", data);
+  }
+
+  // A closed rectangular path, in points
+  unsigned addPath(double x1, double y1, double x2, double y2, unsigned graphicStyleId = 0)
+  {
+    const double xs[] = { x1, x2, x2, x1 };
+    const double ys[] = { y1, y1, y2, y2 };
+    std::vector<unsigned char> data;
+    appendU16(data, 4);
+    appendU16(data, graphicStyleId);
+    appendZeros(data, 6 + 9);
+    appendU8(data, 1);
+    appendU16(data, 4);
+    for (unsigned i = 0; i < 4; ++i)
+    {
+      appendZeros(data, 3);
+      for (unsigned j = 0; j < 3; ++j)
+      {
+        appendCoordinate(data, xs[i]);
+        appendCoordinate(data, ys[i]);
+      }
+    }
+    return addRecord("Path", data);
+  }
+
+  unsigned addProcessColor(unsigned red, unsigned green, unsigned blue)
+  {
+    std::vector<unsigned char> data;
+    appendZeros(data, 4);
+    appendU16(data, red);
+    appendU16(data, green);
+    appendU16(data, blue);
+    appendZeros(data, 4 + 8);
+    return addRecord("ProcessColor", data);
+  }
+
+  unsigned addBasicFill(unsigned colorId)
+  {
+    std::vector<unsigned char> data;
+    appendU16(data, colorId);
+    appendZeros(data, 4);
+    return addRecord("BasicFill", data);
+  }
+
+  // A property list with one property
+  unsigned addPropList(unsigned nameId, unsigned valueId)
+  {
+    std::vector<unsigned char> data;
+    appendU16(data, 1);
+    appendU16(data, 1);
+    appendZeros(data, 4);
+    appendU16(data, nameId);
+    appendU16(data, valueId);
+    return addRecord("PropLst", data);
+  }
+
+  unsigned addCompositePath(unsigned elementsId)
+  {
+    std::vector<unsigned char> data;
+    appendZeros(data, 4 + 8);
+    appendU16(data, elementsId);
+    return addRecord("CompositePath", data);
+  }
+
+  unsigned addGroup(unsigned elementsId)
+  {
+    std::vector<unsigned char> data;
+    appendZeros(data, 4 + 8);
+    appendU16(data, elementsId);
+    appendU16(data, 0);
+    return addRecord("Group", data);
+  }
+
+  unsigned addLayer(unsigned elementsId, unsigned nameId, bool visible)
+  {
+    std::vector<unsigned char> data;
+    appendZeros(data, 2 + 4 + 6);
+    appendU16(data, elementsId);
+    appendU16(data, nameId);
+    appendU16(data, visible ? 3 : 0);
+    appendU16(data, 0);
+    return addRecord("Layer", data);
+  }
+
+  unsigned addBlock(unsigned layerListId)
+  {
+    std::vector<unsigned char> data;
+    for (unsigned i = 0; i < 12; ++i)
+      appendU16(data, i == 5 ? layerListId : 0);
+    appendZeros(data, 14);
+    return addRecord("Block", data);
+  }
+
+  // A page of a multi-page document, in points
+  unsigned addPage(double x, double y, double width, double height)
+  {
+    const unsigned keys[] = { 0x1c24, 0x1c2c, 0x1c34, 0x1c3c };
+    const double values[] = { x, y, width, height };
+    std::vector<unsigned char> data;
+    appendU32(data, 0);
+    appendU16(data, 4);
+    appendU16(data, 0);
+    for (unsigned i = 0; i < 4; ++i)
+    {
+      appendU16(data, 0);
+      appendU16(data, keys[i]);
+      appendCoordinate(data, values[i]);
+    }
+    return addRecord("VMpObj", data);
+  }
+
+  // The id that the next record gets
+  unsigned nextId() const
+  {
+    return (unsigned)m_records.size() + 1;
+  }
+
+  std::vector<unsigned char> build(unsigned blockId, double width, double height) const
+  {
+    std::vector<unsigned char> body(m_data);
+    const std::vector<unsigned char>::size_type tail = body.size();
+    appendU16(body, blockId);
+    appendZeros(body, 0x1a - 2);
+    appendCoordinate(body, width);
+    appendCoordinate(body, height);
+    appendZeros(body, 0x32 - unsigned(body.size() - tail));
+
+    std::vector<unsigned char> document;
+    const char magic[] = "AGD3";
+    document.insert(document.end(), magic, magic + 4);
+    appendU32(document, 0);
+    appendU32(document, unsigned(12 + body.size()));
+    document.insert(document.end(), body.begin(), body.end());
+    appendU16(document, (unsigned)m_tokens.size());
+    appendU16(document, 0);
+    for (std::vector<std::string>::size_type i = 0; i < m_tokens.size(); ++i)
+    {
+      appendU16(document, unsigned(0x100 + i));
+      appendU16(document, 0);
+      document.insert(document.end(), m_tokens[i].begin(), m_tokens[i].end());
+      appendZeros(document, 3);
+    }
+    appendU32(document, (unsigned)m_records.size());
+    for (unsigned record : m_records)
+      appendU16(document, 0x100 + record);
+    return document;
+  }
+
+private:
+  unsigned addRecord(const std::string &token, const std::vector<unsigned char> &data)
+  {
+    std::vector<std::string>::size_type i = 0;
+    while (i < m_tokens.size() && m_tokens[i] != token)
+      ++i;
+    if (i == m_tokens.size())
+      m_tokens.push_back(token);
+    m_records.push_back((unsigned)i);
+    m_data.insert(m_data.end(), data.begin(), data.end());
+    return (unsigned)m_records.size();
+  }
+
+  std::vector<std::string> m_tokens;
+  std::vector<unsigned> m_records;
+  std::vector<unsigned char> m_data;
+};
+
+// A document with one visible layer holding the elements
+std::vector<unsigned char> buildDocument(DocumentBuilder &builder, const std::vector<unsigned> &elements)
+{
+  std::vector<unsigned> layers;
+  layers.push_back(builder.addLayer(builder.addList(elements), 0, true));
+  const unsigned blockId = builder.addBlock(builder.addList(layers));
+  return builder.build(blockId, 612, 792);
+}
+
+// Numbers of paths on each output page
+std::vector<unsigned> renderPaths(const std::vector<unsigned char> &document, const libfreehand::FHParseOptions &options)
+{
+  librevenge::RVNGBinaryData data(&document[0], document.size());
+  librevenge::RVNGStringVector svgOutput;
+  librevenge::RVNGSVGDrawingGenerator generator(svgOutput, "svg");
+  CPPUNIT_ASSERT(libfreehand::FreeHandDocument::parse(data.getDataStream(), &generator, options));
+
+  std::vector<unsigned> paths;
+  for (unsigned i = 0; i < svgOutput.size(); ++i)
+  {
+    const std::string svg(svgOutput[i].cstr());
+    unsigned count = 0;
+    for (std::string::size_type pos = svg.find("<svg:path "); pos != std::string::npos; pos = svg.find("<svg:path ", pos + 1))
+      ++count;
+    paths.push_back(count);
+  }
+  return paths;
+}
+
+}
+
+class FreeHandDocumentTest : public CPPUNIT_NS::TestFixture
+{
+public:
+  virtual void setUp();
+  virtual void tearDown();
+
+private:
+  CPPUNIT_TEST_SUITE(FreeHandDocumentTest);
+  CPPUNIT_TEST(testGetInfo);
+  CPPUNIT_TEST(testPages);
+  CPPUNIT_TEST(testClip);
+  CPPUNIT_TEST(testRecordIndex);
+  CPPUNIT_TEST(testRecordCategories);
+  CPPUNIT_TEST_SUITE_END();
+
+private:
+  void testGetInfo();
+  void testPages();
+  void testClip();
+  void testRecordIndex();
+  void testRecordCategories();
+};
+
+void FreeHandDocumentTest::setUp()
+{
+}
+
+void FreeHandDocumentTest::tearDown()
+{
+}
+
+void FreeHandDocumentTest::testGetInfo()
+{
+  DocumentBuilder builder;
+  const unsigned nameId = builder.addName("Foreground");
+  std::vector<unsigned> subpaths;
+  subpaths.push_back(builder.addPath(72, 72, 144, 144));
+  subpaths.push_back(builder.addPath(90, 90, 120, 120));
+  std::vector<unsigned> elements;
+  elements.push_back(builder.addCompositePath(builder.addList(subpaths)));
+  elements.push_back(builder.addPath(200, 200, 300, 300));
+  std::vector<unsigned> layers;
+  layers.push_back(builder.addLayer(builder.addList(elements), nameId, true));
+  layers.push_back(builder.addLayer(builder.addList(std::vector<unsigned>()), 0, false));
+  builder.addPage(0, 0, 612, 792);
+  const unsigned blockId = builder.addBlock(builder.addList(layers));
+  const std::vector<unsigned char> document = builder.build(blockId, 612, 792);
+
+  librevenge::RVNGBinaryData data(&document[0], document.size());
+  libfreehand::FHDocumentInfo info;
+  CPPUNIT_ASSERT(libfreehand::FreeHandDocument::getInfo(data.getDataStream(), info));
+  CPPUNIT_ASSERT_EQUAL(8, info.m_version);
+  CPPUNIT_ASSERT_DOUBLES_EQUAL(8.5, info.m_pageWidth, 1e-6);
+  CPPUNIT_ASSERT_DOUBLES_EQUAL(11.0, info.m_pageHeight, 1e-6);
+  CPPUNIT_ASSERT_EQUAL(1U, info.m_pageCount);
+  CPPUNIT_ASSERT_EQUAL(13U, info.m_recordCount);
+  // the composite path is not counted on top of its two paths
+  CPPUNIT_ASSERT_EQUAL(3U, info.m_pathCount);
+  CPPUNIT_ASSERT_EQUAL(0U, info.m_textCount);
+  CPPUNIT_ASSERT_EQUAL(0U, info.m_imageCount);
+  CPPUNIT_ASSERT_EQUAL(2UL, info.m_layers.count());
+  CPPUNIT_ASSERT(info.m_layers[0]["librevenge:name"]);
+  CPPUNIT_ASSERT_EQUAL(std::string("Foreground"), std::string(info.m_layers[0]["librevenge:name"]->getStr().cstr()));
+  CPPUNIT_ASSERT(info.m_layers[0]["librevenge:visible"]);
+  CPPUNIT_ASSERT_EQUAL(std::string("true"), std::string(info.m_layers[0]["librevenge:visible"]->getStr().cstr()));
+  CPPUNIT_ASSERT(!info.m_layers[1]["librevenge:name"]);
+  CPPUNIT_ASSERT(info.m_layers[1]["librevenge:visible"]);
+  CPPUNIT_ASSERT_EQUAL(std::string("false"), std::string(info.m_layers[1]["librevenge:visible"]->getStr().cstr()));
+
+  // Two Letter pages side by side; the document spans both
+  DocumentBuilder pagesBuilder;
+  pagesBuilder.addPage(72, 72, 612, 792);
+  pagesBuilder.addPage(684, 72, 612, 792);
+  const unsigned pagesElementsId = pagesBuilder.addList(std::vector<unsigned>(1, pagesBuilder.addPath(144, 144, 216, 216)));
+  const unsigned pagesLayersId = pagesBuilder.addList(std::vector<unsigned>(1, pagesBuilder.addLayer(pagesElementsId, 0, true)));
+  const std::vector<unsigned char> pagesDocument = pagesBuilder.build(pagesBuilder.addBlock(pagesLayersId), 1368, 936);
+  librevenge::RVNGBinaryData pagesData(&pagesDocument[0], pagesDocument.size());
+  CPPUNIT_ASSERT(libfreehand::FreeHandDocument::getInfo(pagesData.getDataStream(), info));
+  CPPUNIT_ASSERT_EQUAL(2U, info.m_pageCount);
+  CPPUNIT_ASSERT_DOUBLES_EQUAL(8.5, info.m_pageWidth, 1e-6);
+  CPPUNIT_ASSERT_DOUBLES_EQUAL(11.0, info.m_pageHeight, 1e-6);
+  CPPUNIT_ASSERT_EQUAL(1U, info.m_pathCount);
+
+  const unsigned char garbage[] = "not a FreeHand document";
+  librevenge::RVNGBinaryData garbageData(garbage, sizeof(garbage));
+  CPPUNIT_ASSERT(!libfreehand::FreeHandDocument::getInfo(garbageData.getDataStream(), info));
+}
+
+void FreeHandDocumentTest::testPages()
+{
+  DocumentBuilder builder;
+  builder.addPage(0, 0, 612, 792);
+  builder.addPage(612, 0, 612, 792);
+  std::vector<unsigned> elements;
+  elements.push_back(builder.addPath(72, 72, 144, 144));   // on the first page
+  elements.push_back(builder.addPath(500, 300, 700, 400)); // on both
+  elements.push_back(builder.addPath(700, 72, 800, 144));  // on the second page
+  elements.push_back(builder.addPath(900, 72, 1000, 144)); // on the second page
+  const std::vector<unsigned char> document = buildDocument(builder, elements);
+
+  libfreehand::FHParseOptions options;
+  std::vector<unsigned> paths = renderPaths(document, options);
+  CPPUNIT_ASSERT_EQUAL(std::vector<unsigned>::size_type(2), paths.size());
+  CPPUNIT_ASSERT_EQUAL(2U, paths[0]);
+  CPPUNIT_ASSERT_EQUAL(3U, paths[1]);
+
+  options.m_firstPage = 1;
+  options.m_lastPage = 1;
+  paths = renderPaths(document, options);
+  CPPUNIT_ASSERT_EQUAL(std::vector<unsigned>::size_type(1), paths.size());
+  CPPUNIT_ASSERT_EQUAL(3U, paths[0]);
+
+  options.m_firstPage = 2;
+  options.m_lastPage = 5;
+  CPPUNIT_ASSERT(renderPaths(document, options).empty());
+
+  // A group that contains itself is drawn once
+  DocumentBuilder cyclicBuilder;
+  cyclicBuilder.addPage(0, 0, 612, 792);
+  cyclicBuilder.addPage(612, 0, 612, 792);
+  std::vector<unsigned> groupElements;
+  groupElements.push_back(cyclicBuilder.addPath(72, 72, 144, 144));
+  groupElements.push_back(cyclicBuilder.nextId() + 1);
+  elements.clear();
+  elements.push_back(cyclicBuilder.addGroup(cyclicBuilder.addList(groupElements)));
+  paths = renderPaths(buildDocument(cyclicBuilder, elements), libfreehand::FHParseOptions());
+  CPPUNIT_ASSERT_EQUAL(std::vector<unsigned>::size_type(2), paths.size());
+  CPPUNIT_ASSERT_EQUAL(1U, paths[0]);
+}
+
+void FreeHandDocumentTest::testClip()
+{
+  DocumentBuilder builder;
+  std::vector<unsigned> groupElements;
+  groupElements.push_back(builder.addPath(72, 72, 144, 144));
+  groupElements.push_back(builder.addPath(400, 600, 500, 700));
+  std::vector<unsigned> elements;
+  elements.push_back(builder.addGroup(builder.addList(groupElements)));
+  elements.push_back(builder.addPath(400, 100, 500, 200));
+  const std::vector<unsigned char> document = buildDocument(builder, elements);
+
+  libfreehand::FHParseOptions options;
+  std::vector<unsigned> paths = renderPaths(document, options);
+  CPPUNIT_ASSERT_EQUAL(std::vector<unsigned>::size_type(1), paths.size());
+  CPPUNIT_ASSERT_EQUAL(3U, paths[0]);
+
+  // Around the first path, which is 1 to 2 inches from the bottom left
+  // corner. The group is kept, without its other path.
+  options.m_clip = true;
+  options.m_clipX = 0.5;
+  options.m_clipY = 8.5;
+  options.m_clipWidth = 2;
+  options.m_clipHeight = 2;
+  paths = renderPaths(document, options);
+  CPPUNIT_ASSERT_EQUAL(std::vector<unsigned>::size_type(1), paths.size());
+  CPPUNIT_ASSERT_EQUAL(1U, paths[0]);
+
+  // The whole page
+  options.m_clipX = 0;
+  options.m_clipY = 0;
+  options.m_clipWidth = 8.5;
+  options.m_clipHeight = 11;
+  paths = renderPaths(document, options);
+  CPPUNIT_ASSERT_EQUAL(3U, paths[0]);
+
+  // Off the page
+  options.m_clipX = 20;
+  paths = renderPaths(document, options);
+  CPPUNIT_ASSERT_EQUAL(std::vector<unsigned>::size_type(1), paths.size());
+  CPPUNIT_ASSERT_EQUAL(0U, paths[0]);
+
+  // A group that contains itself is drawn once
+  DocumentBuilder cyclicBuilder;
+  groupElements.clear();
+  groupElements.push_back(cyclicBuilder.addPath(72, 72, 144, 144));
+  groupElements.push_back(cyclicBuilder.nextId() + 1);
+  elements.clear();
+  elements.push_back(cyclicBuilder.addGroup(cyclicBuilder.addList(groupElements)));
+  options.m_clipX = 0;
+  paths = renderPaths(buildDocument(cyclicBuilder, elements), options);
+  CPPUNIT_ASSERT_EQUAL(std::vector<unsigned>::size_type(1), paths.size());
+  CPPUNIT_ASSERT_EQUAL(1U, paths[0]);
+}
+
+void FreeHandDocumentTest::testRecordIndex()
+{
+  DocumentBuilder builder;
+  builder.addPage(0, 0, 612, 792);
+  builder.addPage(612, 0, 612, 792);
+  std::vector<unsigned> subpaths;
+  subpaths.push_back(builder.addPath(72, 72, 144, 144));
+  subpaths.push_back(builder.addPath(90, 90, 120, 120));
+  std::vector<unsigned> groupElements;
+  groupElements.push_back(builder.addCompositePath(builder.addList(subpaths)));
+  groupElements.push_back(builder.addPath(700, 72, 800, 144));
+  std::vector<unsigned> elements;
+  elements.push_back(builder.addGroup(builder.addList(groupElements)));
+  elements.push_back(builder.addPath(500, 300, 700, 400));
+  const std::vector<unsigned char> document = buildDocument(builder, elements);
+  librevenge::RVNGBinaryData data(&document[0], document.size());
+
+  libfreehand::FHParser parser;
+  CPPUNIT_ASSERT(!parser.parseFromIndex(data.getDataStream(), nullptr));
+
+  librevenge::RVNGStringVector sequentialOutput;
+  librevenge::RVNGSVGDrawingGenerator sequentialGenerator(sequentialOutput, "svg");
+  CPPUNIT_ASSERT(parser.parse(data.getDataStream(), &sequentialGenerator));
+
+  const std::vector<libfreehand::FHParser::RecordOffset> &offsets = parser.getRecordOffsets();
+  CPPUNIT_ASSERT_EQUAL(std::vector<libfreehand::FHParser::RecordOffset>::size_type(builder.nextId() - 1), offsets.size());
+  CPPUNIT_ASSERT_EQUAL(0L, offsets[0].m_offset);
+  for (std::vector<libfreehand::FHParser::RecordOffset>::size_type i = 0; i < offsets.size(); ++i)
+  {
+    CPPUNIT_ASSERT_EQUAL(unsigned(i + 1), offsets[i].m_id);
+    if (i)
+      CPPUNIT_ASSERT(offsets[i - 1].m_offset < offsets[i].m_offset);
+  }
+
+  librevenge::RVNGStringVector indexedOutput;
+  librevenge::RVNGSVGDrawingGenerator indexedGenerator(indexedOutput, "svg");
+  CPPUNIT_ASSERT(parser.parseFromIndex(data.getDataStream(), &indexedGenerator));
+  CPPUNIT_ASSERT_EQUAL(2U, sequentialOutput.size());
+  CPPUNIT_ASSERT_EQUAL(sequentialOutput.size(), indexedOutput.size());
+  for (unsigned i = 0; i < sequentialOutput.size(); ++i)
+    CPPUNIT_ASSERT_EQUAL(std::string(sequentialOutput[i].cstr()), std::string(indexedOutput[i].cstr()));
+}
+
+void FreeHandDocumentTest::testRecordCategories()
+{
+  DocumentBuilder builder;
+  const unsigned fillId = builder.addName("fill");
+  const unsigned colorId = builder.addProcessColor(0xffff, 0, 0);
+  const unsigned styleId = builder.addPropList(fillId, builder.addBasicFill(colorId));
+  std::vector<unsigned> elements;
+  elements.push_back(builder.addPath(72, 72, 144, 144, styleId));
+  elements.push_back(builder.addPath(200, 200, 300, 300));
+  const std::vector<unsigned char> document = buildDocument(builder, elements);
+
+  libfreehand::FHParseOptions options;
+  std::vector<unsigned> paths = renderPaths(document, options);
+  CPPUNIT_ASSERT_EQUAL(std::vector<unsigned>::size_type(1), paths.size());
+  CPPUNIT_ASSERT_EQUAL(2U, paths[0]);
+
+  options.m_recordCategories = libfreehand::FH_RECORDS_TEXT;
+  paths = renderPaths(document, options);
+  CPPUNIT_ASSERT_EQUAL(std::vector<unsigned>::size_type(1), paths.size());
+  CPPUNIT_ASSERT_EQUAL(0U, paths[0]);
+
+  // The skipped style and color records are still read past, so the paths
+  // after them are found
+  options.m_recordCategories = libfreehand::FH_RECORDS_GEOMETRY;
+  paths = renderPaths(document, options);
+  CPPUNIT_ASSERT_EQUAL(std::vector<unsigned>::size_type(1), paths.size());
+  CPPUNIT_ASSERT_EQUAL(2U, paths[0]);
+
+  options.m_recordCategories = libfreehand::FH_RECORDS_ALL & ~libfreehand::FH_RECORDS_COLORS;
+  paths = renderPaths(document, options);
+  CPPUNIT_ASSERT_EQUAL(std::vector<unsigned>::size_type(1), paths.size());
+  CPPUNIT_ASSERT_EQUAL(2U, paths[0]);
+}
+
+CPPUNIT_TEST_SUITE_REGISTRATION(FreeHandDocumentTest);
+
+}
+
+/* vim:set shiftwidth=2 softtabstop=2 expandtab: */